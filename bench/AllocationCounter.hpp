@@ -0,0 +1,78 @@
+#ifndef ALLOCATIONCOUNTER_HPP
+#define ALLOCATIONCOUNTER_HPP
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Replaces the global allocation functions so a benchmark can count heap allocations.
+// Include it from exactly one translation unit of each benchmark binary.
+namespace bench {
+inline std::atomic<uint64_t> allocationCount{0};
+
+inline uint64_t allocations() {
+    return allocationCount.load(std::memory_order_relaxed);
+}
+
+inline void *countedAlloc(std::size_t size, std::size_t alignment) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    void *p = alignment > alignof(std::max_align_t)
+                  ? std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment)
+                  : std::malloc(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+} // namespace bench
+
+void *operator new(std::size_t size) {
+    return bench::countedAlloc(size, 0);
+}
+
+void *operator new[](std::size_t size) {
+    return bench::countedAlloc(size, 0);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return bench::countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return bench::countedAlloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete(void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void *p, std::size_t, std::align_val_t) noexcept {
+    std::free(p);
+}
+
+#endif
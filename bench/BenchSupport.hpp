@@ -0,0 +1,527 @@
+#ifndef BENCHSUPPORT_HPP
+#define BENCHSUPPORT_HPP
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <memory>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <sys/resource.h>
+#endif
+
+#include "../include/LatencyHistogram.hpp"
+#include "../include/OrderBook.hpp"
+#include "../include/TickRecord.hpp"
+
+// Pieces shared by the benchmark binaries: the tick stream, pacing, per-stage measurement and
+// the machine-readable report that runs are compared with.
+namespace bench {
+
+// Synthetic stream shape. Symbols are "S0", "S1", ...; with skew > 0 symbol k is drawn with
+// weight 1 / (k + 1)^skew, so a few symbols carry most of the flow.
+struct StreamConfig {
+    uint64_t seed = 42;
+    size_t ticks = 1000000;
+    size_t symbols = 64;
+    double skew = 0.0;
+    double rate = 0.0; // Ticks per second; 0 sends as fast as the pipeline takes them
+    size_t burst = 1;  // Ticks sent back to back at each scheduled instant
+};
+
+// Per-symbol random walk on a one-cent grid around 100.00; timestamps follow the configured
+// rate (one microsecond apart when unpaced)
+inline std::vector<TickRecord> generateStream(const StreamConfig &config) {
+    std::mt19937_64 rng(config.seed);
+    std::vector<double> weights;
+    for (size_t k = 0; k < config.symbols; ++k) {
+        weights.push_back(1.0 / std::pow(static_cast<double>(k + 1), config.skew));
+    }
+    std::discrete_distribution<size_t> symbol(weights.begin(), weights.end());
+    std::uniform_int_distribution<int> step(-1, 1);
+    std::uniform_int_distribution<int32_t> volume(1, 100);
+
+    const int64_t cent = TickRecord::PRICE_SCALE / 100;
+    std::vector<uint64_t> codes;
+    std::vector<int64_t> prices(config.symbols, 100 * TickRecord::PRICE_SCALE);
+    for (size_t k = 0; k < config.symbols; ++k) {
+        codes.push_back(TickRecord::encodeSymbol("S" + std::to_string(k)));
+    }
+
+    double spacingNs = config.rate > 0.0 ? 1e9 / config.rate : 1000.0;
+    std::vector<TickRecord> ticks;
+    ticks.reserve(config.ticks);
+    for (size_t i = 0; i < config.ticks; ++i) {
+        size_t k = symbol(rng);
+        prices[k] = std::max<int64_t>(cent, prices[k] + step(rng) * cent);
+        int64_t timestamp = static_cast<int64_t>(static_cast<double>(i) * spacingNs);
+        ticks.push_back({codes[k], prices[k], timestamp, volume(rng), 0});
+    }
+    return ticks;
+}
+
+// The ticks a run replays: generated in memory, or mapped from a tick file
+class TickStream {
+  public:
+    static TickStream generate(const StreamConfig &config) {
+        TickStream stream;
+        stream.owned_ = generateStream(config);
+        stream.ticks_ = stream.owned_;
+        return stream;
+    }
+
+    static TickStream replay(const std::string &path) {
+        TickStream stream;
+        stream.reader_ = std::make_unique<TickFileReader>(path);
+        stream.ticks_ = stream.reader_->records();
+        return stream;
+    }
+
+    std::span<const TickRecord> ticks() const {
+        return ticks_;
+    }
+
+    // Whether every component takes the tick: TickProcessor drops anything else and
+    // VWAPCalculator throws on a non-positive volume
+    static bool valid(const TickRecord &tick) {
+        return !tick.symbolName().empty() && tick.priceTicks > 0 && tick.volume > 0;
+    }
+
+    // Remove the ticks valid() rejects, e.g. from a replayed file; returns how many
+    size_t dropInvalid() {
+        size_t invalid = static_cast<size_t>(std::count_if(
+            ticks_.begin(), ticks_.end(), [](const TickRecord &t) { return !valid(t); }));
+        if (invalid == 0) return 0;
+        std::vector<TickRecord> kept;
+        kept.reserve(ticks_.size() - invalid);
+        std::copy_if(ticks_.begin(), ticks_.end(), std::back_inserter(kept), valid);
+        owned_ = std::move(kept);
+        ticks_ = owned_;
+        reader_.reset();
+        return invalid;
+    }
+
+    void record(const std::string &path) const {
+        TickFileWriter writer(path);
+        writer.write(ticks_);
+        writer.close();
+    }
+
+  private:
+    std::vector<TickRecord> owned_;
+    std::unique_ptr<TickFileReader> reader_;
+    std::span<const TickRecord> ticks_;
+};
+
+// Dense per-symbol index of each tick, in order of first appearance. symbols is set to the
+// number of distinct symbols.
+inline std::vector<uint32_t> symbolIndices(std::span<const TickRecord> ticks, size_t &symbols) {
+    std::unordered_map<uint64_t, uint32_t> index;
+    std::vector<uint32_t> out;
+    out.reserve(ticks.size());
+    for (const TickRecord &tick : ticks) {
+        auto [it, inserted] = index.emplace(tick.symbol, static_cast<uint32_t>(index.size()));
+        out.push_back(it->second);
+    }
+    symbols = index.size();
+    return out;
+}
+
+inline uint64_t nowNs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                     std::chrono::steady_clock::now().time_since_epoch())
+                                     .count());
+}
+
+// Releases ticks on schedule: burst ticks at a time, bursts spaced to average rate ticks per
+// second. Waits by spinning on the clock, since sleeping would oversleep short gaps, and
+// yields while the next burst is still far off so a shared core can run the consumer.
+class Pacer {
+  public:
+    Pacer(double rate, size_t burst) : rate_(rate), burst_(std::max<size_t>(1, burst)) {}
+
+    void start() {
+        startNs_ = nowNs();
+    }
+
+    // Call before sending tick i
+    void wait(size_t i) {
+        if (rate_ <= 0.0 || i % burst_ != 0) return;
+        uint64_t due = startNs_ + static_cast<uint64_t>(static_cast<double>(i) * 1e9 / rate_);
+        for (uint64_t now = nowNs(); now < due; now = nowNs()) {
+            if (due - now > YIELD_NS) std::this_thread::yield();
+        }
+    }
+
+  private:
+    static constexpr uint64_t YIELD_NS = 20000;
+
+    double rate_;
+    size_t burst_;
+    uint64_t startNs_ = 0;
+};
+
+// Peak resident set of this process so far, in KiB (0 where unknown)
+inline long peakRssKb() {
+#ifdef __linux__
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0) return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+// Reference data the pipeline looks up per tick through an LRUCache
+struct RefData {
+    int64_t tickSize;
+    int32_t lotSize;
+    double maxNotional;
+};
+
+// Stand-in for a reference-data service: deterministic per symbol and deliberately not free
+inline RefData loadRefData(uint64_t symbol) {
+    uint64_t h = symbol;
+    for (int i = 0; i < 16; ++i) {
+        h = (h ^ (h >> 31)) * 0x9E3779B97F4A7C15ull;
+    }
+    return {TickRecord::PRICE_SCALE / 100, static_cast<int32_t>(1 + h % 100),
+            1e6 * static_cast<double>(1 + (h >> 8) % 10)};
+}
+
+// Turns a symbol's ticks into order flow for its book: a tick above the symbol's previous
+// price buys at that price, anything else sells, so orders cross whenever the walk reverses.
+// The oldest of a symbol's last LIVE orders is cancelled as each new one arrives, which keeps
+// every book bounded.
+class TickOrderFlow {
+  public:
+    static constexpr size_t LIVE = 32;
+
+    template <typename Book> void apply(Book &book, size_t symbol, const TickRecord &tick) {
+        if (symbol >= states_.size()) states_.resize(symbol + 1);
+        State &state = states_[symbol];
+        OrderBookTypes::Side side =
+            tick.priceTicks > state.lastPrice ? OrderBookTypes::BUY : OrderBookTypes::SELL;
+        state.lastPrice = tick.priceTicks;
+
+        int &slot = state.live[state.next];
+        if (slot) book.cancelOrder(slot);
+        slot = nextID_++;
+        state.next = (state.next + 1) % LIVE;
+        book.addOrder(side, tick.price(), tick.volume, slot);
+    }
+
+  private:
+    struct State {
+        int64_t lastPrice = 0;
+        int live[LIVE] = {};
+        size_t next = 0;
+    };
+
+    std::vector<State> states_;
+    int nextID_ = 1;
+};
+
+// Ladder books cover each symbol's lowest to highest price in the stream, in cents
+constexpr double LADDER_TICK = 0.01;
+
+struct PriceBand {
+    double low;
+    double high;
+};
+
+// Price band of each symbol, indexed as symbolIndices() numbers them
+inline std::vector<PriceBand> priceBands(std::span<const TickRecord> ticks,
+                                         const std::vector<uint32_t> &ids, size_t symbols) {
+    std::vector<PriceBand> bands(symbols, {std::numeric_limits<double>::max(), 0.0});
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        PriceBand &band = bands[ids[i]];
+        band.low = std::min(band.low, ticks[i].price());
+        band.high = std::max(band.high, ticks[i].price());
+    }
+    return bands;
+}
+
+// Book sink that adds every rejected add to a shared count, so orders a book turns away (off
+// its ladder's ticks, say) show in the report instead of passing for fast matching. Cancels of
+// orders that have already filled are part of TickOrderFlow and are not counted.
+class RejectCounter : public NullSink {
+  public:
+    explicit RejectCounter(uint64_t &rejects) : rejects_(&rejects) {}
+
+    void onReject(const Reject &reject) {
+        if (reject.request == ADD) ++*rejects_;
+    }
+
+  private:
+    uint64_t *rejects_;
+};
+
+// Named results of one run. Names ending in _per_s are better when higher; names ending in
+// _count, and the single worst sample _max_ns, are informational; everything else
+// (latencies, allocations, memory) is better when lower.
+class Report {
+  public:
+    explicit Report(std::string bench) : bench_(std::move(bench)) {}
+
+    void setConfig(const std::string &key, const std::string &value) {
+        config_.emplace_back(key, value);
+    }
+
+    void add(const std::string &name, double value) {
+        metrics_.emplace_back(name, value);
+    }
+
+    // count, p50, p99, p99.9 and max of a stage's latencies (ns), plus allocations per operation
+    void addStage(const std::string &stage, const LatencyHistogram &latency,
+                  uint64_t allocations = 0) {
+        add(stage + "_count", static_cast<double>(latency.count()));
+        add(stage + "_p50_ns", static_cast<double>(latency.percentile(0.50)));
+        add(stage + "_p99_ns", static_cast<double>(latency.percentile(0.99)));
+        add(stage + "_p999_ns", static_cast<double>(latency.percentile(0.999)));
+        add(stage + "_max_ns", static_cast<double>(latency.max()));
+        if (latency.count()) {
+            add(stage + "_allocs_per_op",
+                static_cast<double>(allocations) / static_cast<double>(latency.count()));
+        }
+    }
+
+    void print() const {
+        std::cout << "=== " << bench_ << " ===" << std::endl;
+        for (const auto &[key, value] : config_) {
+            std::cout << key << "=" << value << " ";
+        }
+        std::cout << std::endl;
+        for (const auto &[name, value] : metrics_) {
+            std::cout << std::left << std::setw(36) << name << std::right << std::setw(18)
+                      << format(value) << std::endl;
+        }
+    }
+
+    // One JSON object: {"bench": ..., "config": {...}, "metrics": {...}}; "-" is stdout.
+    // The text is read back before it is written, so a file compare() would misread is never
+    // produced.
+    void writeJson(const std::string &path) const {
+        std::string json = toJson();
+        std::map<std::string, double> parsed = parseMetrics(json, "JSON output");
+        for (const auto &[name, value] : metrics_) {
+            auto it = parsed.find(name);
+            if (it == parsed.end() || (it->second != value && !std::isnan(value))) {
+                throw std::logic_error("Metric " + name + " does not round-trip through JSON");
+            }
+        }
+        if (path == "-") {
+            std::cout << json;
+            return;
+        }
+        std::ofstream file(path);
+        if (!file) throw std::runtime_error("Cannot write " + path);
+        file << json;
+    }
+
+    // Compare with the metrics of an earlier writeJson() file. Prints every shared metric with
+    // its change and returns how many moved the wrong way by more than tolerance (a fraction).
+    int compare(const std::string &baselinePath, double tolerance) const {
+        std::map<std::string, double> baseline = readMetrics(baselinePath);
+        int regressions = 0;
+        std::cout << "\n=== Against " << baselinePath << " (tolerance " << tolerance * 100
+                  << "%) ===" << std::endl;
+        for (const auto &[name, value] : metrics_) {
+            auto it = baseline.find(name);
+            if (it == baseline.end() || !compared(name)) continue;
+            double before = it->second;
+            double change = before != 0.0 ? (value - before) / std::abs(before) : 0.0;
+            bool higherIsBetter = endsWith(name, "_per_s");
+            bool regressed = higherIsBetter ? change < -tolerance : change > tolerance;
+            // Tiny absolute values (0 vs 0.001 allocations) are noise, not regressions
+            if (!higherIsBetter && std::abs(value - before) < 1e-3) regressed = false;
+            regressions += regressed;
+            std::cout << std::left << std::setw(36) << name << std::right << std::setw(16)
+                      << format(before) << " -> " << std::setw(16) << format(value) << std::setw(9)
+                      << std::fixed << std::setprecision(1) << change * 100 << "%"
+                      << (regressed ? "  REGRESSION" : "") << std::defaultfloat << std::endl;
+        }
+        std::cout << regressions << " regression(s)" << std::endl;
+        return regressions;
+    }
+
+  private:
+    std::string bench_;
+    std::vector<std::pair<std::string, std::string>> config_;
+    std::vector<std::pair<std::string, double>> metrics_;
+
+    static bool endsWith(const std::string &s, const std::string &suffix) {
+        return s.size() >= suffix.size() &&
+               s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+    }
+
+    static bool compared(const std::string &name) {
+        return !endsWith(name, "_count") && !endsWith(name, "_max_ns");
+    }
+
+    static std::string format(double value) {
+        std::ostringstream out;
+        if (value == std::floor(value) && std::abs(value) < 1e15) {
+            out << static_cast<long long>(value);
+        } else {
+            out << std::fixed << std::setprecision(3) << value;
+        }
+        return out.str();
+    }
+
+    std::string toJson() const {
+        std::ostringstream out;
+        out << "{\n  \"bench\": " << quote(bench_) << ",\n  \"config\": {";
+        for (size_t i = 0; i < config_.size(); ++i) {
+            out << (i ? ", " : "") << quote(config_[i].first) << ": " << quote(config_[i].second);
+        }
+        out << "},\n  \"metrics\": {\n";
+        out << std::setprecision(17);
+        for (size_t i = 0; i < metrics_.size(); ++i) {
+            out << "    " << quote(metrics_[i].first) << ": " << metrics_[i].second
+                << (i + 1 < metrics_.size() ? ",\n" : "\n");
+        }
+        out << "  }\n}\n";
+        return out.str();
+    }
+
+    // s as a JSON string literal; a --replay path may hold quotes, backslashes or control bytes
+    static std::string quote(const std::string &s) {
+        std::ostringstream out;
+        out << '"';
+        for (unsigned char c : s) {
+            if (c == '"' || c == '\\') {
+                out << '\\' << c;
+            } else if (c < 0x20) {
+                out << "\\u" << std::hex << std::setw(4) << std::setfill('0') << int(c)
+                    << std::dec << std::setfill(' ');
+            } else {
+                out << c;
+            }
+        }
+        out << '"';
+        return out.str();
+    }
+
+    static std::map<std::string, double> readMetrics(const std::string &path) {
+        std::ifstream in(path);
+        if (!in) throw std::runtime_error("Cannot read " + path);
+        std::stringstream buffer;
+        buffer << in.rdbuf();
+        return parseMetrics(buffer.str(), path);
+    }
+
+    // The "name": number pairs of a toJson() text's metrics object
+    static std::map<std::string, double> parseMetrics(const std::string &text,
+                                                      const std::string &source) {
+        size_t pos = text.rfind("\"metrics\"");
+        if (pos != std::string::npos) pos = text.find('{', pos);
+        if (pos == std::string::npos) throw std::runtime_error("No metrics in " + source);
+        std::map<std::string, double> metrics;
+        while (true) {
+            // pos is at the object's '{' or at the ',' after the previous pair
+            size_t key = text.find_first_of("\"}", pos + 1);
+            if (key == std::string::npos || text[key] == '}') break;
+            size_t end = text.find('"', key + 1);
+            size_t colon = end == std::string::npos ? end : text.find(':', end);
+            if (colon == std::string::npos) {
+                throw std::runtime_error("Malformed metrics in " + source);
+            }
+            metrics[text.substr(key + 1, end - key - 1)] = std::stod(text.substr(colon + 1));
+            pos = text.find_first_of(",}", colon);
+            if (pos == std::string::npos || text[pos] == '}') break;
+        }
+        return metrics;
+    }
+};
+
+inline std::string argValue(const std::string &arg, const std::string &key) {
+    std::string prefix = "--" + key + "=";
+    return arg.compare(0, prefix.size(), prefix) == 0 ? arg.substr(prefix.size()) : std::string();
+}
+
+// Options every benchmark takes. Returns false if arg is not one of them.
+struct CommonOptions {
+    StreamConfig stream;
+    std::string replayPath;
+    std::string recordPath;
+    std::string jsonPath;
+    std::string baselinePath;
+    double tolerance = 0.05;
+    size_t droppedTicks = 0; // Invalid ticks load() removed from the stream
+
+    bool parse(const std::string &arg) {
+        std::string v;
+        if (!(v = argValue(arg, "ticks")).empty()) stream.ticks = std::stoull(v);
+        else if (!(v = argValue(arg, "symbols")).empty()) stream.symbols = std::stoull(v);
+        else if (!(v = argValue(arg, "seed")).empty()) stream.seed = std::stoull(v);
+        else if (!(v = argValue(arg, "skew")).empty()) stream.skew = std::stod(v);
+        else if (!(v = argValue(arg, "rate")).empty()) stream.rate = std::stod(v);
+        else if (!(v = argValue(arg, "burst")).empty()) stream.burst = std::stoull(v);
+        else if (!(v = argValue(arg, "replay")).empty()) replayPath = v;
+        else if (!(v = argValue(arg, "record")).empty()) recordPath = v;
+        else if (!(v = argValue(arg, "json")).empty()) jsonPath = v;
+        else if (!(v = argValue(arg, "baseline")).empty()) baselinePath = v;
+        else if (!(v = argValue(arg, "tolerance")).empty()) tolerance = std::stod(v);
+        else return false;
+        return true;
+    }
+
+    // Only valid ticks are returned, so every component sees, and every consumer waits for,
+    // the same count
+    TickStream load() {
+        if (stream.symbols == 0 || stream.symbols > 10000000) {
+            throw std::invalid_argument("--symbols must be between 1 and 10000000");
+        }
+        TickStream ticks = replayPath.empty() ? TickStream::generate(stream)
+                                              : TickStream::replay(replayPath);
+        droppedTicks = ticks.dropInvalid();
+        if (droppedTicks) {
+            std::cerr << "Dropped " << droppedTicks << " invalid ticks" << std::endl;
+        }
+        if (ticks.ticks().empty()) throw std::invalid_argument("Stream has no valid ticks");
+        if (!recordPath.empty()) ticks.record(recordPath);
+        return ticks;
+    }
+
+    void describe(Report &report) const {
+        if (replayPath.empty()) {
+            report.setConfig("source", "synthetic");
+            report.setConfig("seed", std::to_string(stream.seed));
+            report.setConfig("symbols", std::to_string(stream.symbols));
+            report.setConfig("skew", std::to_string(stream.skew));
+        } else {
+            report.setConfig("source", replayPath);
+        }
+        report.setConfig("rate", std::to_string(stream.rate));
+        report.setConfig("burst", std::to_string(stream.burst));
+    }
+
+    // Print, write JSON and compare as requested; the exit code is 3 on a regression
+    int finish(Report &report) const {
+        report.add("dropped_ticks_count", static_cast<double>(droppedTicks));
+        report.add("peak_rss_kb", static_cast<double>(peakRssKb()));
+        report.print();
+        if (!jsonPath.empty()) report.writeJson(jsonPath);
+        if (!baselinePath.empty() && report.compare(baselinePath, tolerance) > 0) return 3;
+        return 0;
+    }
+};
+
+} // namespace bench
+
+#endif
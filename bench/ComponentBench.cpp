@@ -0,0 +1,299 @@
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/CircularBuffer.hpp"
+#include "../include/LRUCache.hpp"
+#include "../include/LatencyHistogram.hpp"
+#include "../include/MarketDataProcessor.hpp"
+#include "../include/OrderBook.hpp"
+#include "../include/ThreadSafeQueue.hpp"
+#include "../include/TickProcessor.hpp"
+#include "../include/TickRecord.hpp"
+#include "../include/VWAPCalculator.hpp"
+#include "AllocationCounter.hpp"
+#include "BenchSupport.hpp"
+
+// Per-component benchmarks over the same stream as PipelineBench, one component at a time.
+//
+//   ComponentBench [--component=queue|tickprocessor|market|vwap|book|cache|all]
+//                  [--ticks=N] [--symbols=N] [--seed=S] [--skew=Z] [--rate=TICKS_PER_S]
+//                  [--burst=N] [--replay=FILE] [--record=FILE] [--cache=ENTRIES]
+//                  [--queue=CAPACITY] [--json=FILE|-] [--baseline=FILE] [--tolerance=FRACTION]
+//
+// queue and tickprocessor run a producer against their consumer threads and honour --rate and
+// --burst. The single-threaded components are called back to back: one untimed pass gives
+// throughput and allocations per tick, a second pass times every call.
+
+namespace {
+
+struct SentTick {
+    TickRecord tick;
+    uint64_t sentNs;
+};
+
+// Runs op(state, tick, symbol) over the stream on a fresh make() state per pass
+template <typename Make, typename Op>
+void measureOps(bench::Report &report, const std::string &name, std::span<const TickRecord> ticks,
+                const std::vector<uint32_t> &ids, Make make, Op op) {
+    double n = static_cast<double>(ticks.size());
+    uint64_t allocations;
+    {
+        auto state = make();
+        uint64_t allocationsBefore = bench::allocations();
+        uint64_t start = bench::nowNs();
+        for (size_t i = 0; i < ticks.size(); ++i) {
+            op(*state, ticks[i], ids[i]);
+        }
+        uint64_t elapsed = bench::nowNs() - start;
+        allocations = bench::allocations() - allocationsBefore;
+        report.add(name + "_ticks_per_s",
+                   n * 1e9 / static_cast<double>(std::max<uint64_t>(1, elapsed)));
+    }
+    LatencyHistogram latency;
+    {
+        auto state = make();
+        for (size_t i = 0; i < ticks.size(); ++i) {
+            uint64_t t0 = bench::nowNs();
+            op(*state, ticks[i], ids[i]);
+            latency.record(bench::nowNs() - t0);
+        }
+    }
+    report.addStage(name, latency, allocations);
+}
+
+// Send-to-receive latency through one producer and one consumer
+template <typename Policy>
+void benchQueue(bench::Report &report, const std::string &name, std::span<const TickRecord> ticks,
+                const bench::StreamConfig &stream, size_t capacity) {
+    ThreadSafeQueue<SentTick, Policy> queue(capacity);
+    bench::Pacer pacer(stream.rate, stream.burst);
+    LatencyHistogram latency;
+    uint64_t allocationsBefore = bench::allocations();
+    uint64_t start = bench::nowNs();
+    std::thread producer([&]() {
+        pacer.start();
+        for (size_t i = 0; i < ticks.size(); ++i) {
+            pacer.wait(i);
+            queue.push({ticks[i], bench::nowNs()});
+        }
+    });
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        SentTick sent = queue.pop();
+        latency.record(bench::nowNs() - sent.sentNs);
+    }
+    uint64_t elapsed = bench::nowNs() - start;
+    producer.join();
+    uint64_t allocations = bench::allocations() - allocationsBefore;
+    report.add(name + "_ticks_per_s",
+               static_cast<double>(ticks.size()) * 1e9 / static_cast<double>(elapsed));
+    report.addStage(name, latency, allocations);
+}
+
+// addTick latency on the producer side, throughput until the workers have applied every tick
+void benchTickProcessor(bench::Report &report, std::span<const TickRecord> ticks,
+                        const bench::StreamConfig &stream) {
+    TickProcessor<SpscQueue<Tick, 65536, SpinPark>> processor;
+    processor.start();
+    bench::Pacer pacer(stream.rate, stream.burst);
+    LatencyHistogram latency;
+    uint64_t allocationsBefore = bench::allocations();
+    uint64_t start = bench::nowNs();
+    pacer.start();
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        pacer.wait(i);
+        uint64_t t0 = bench::nowNs();
+        processor.addTick(ticks[i]);
+        latency.record(bench::nowNs() - t0);
+    }
+    while (processor.getProcessedCount() < static_cast<int>(ticks.size())) {
+        std::this_thread::yield();
+    }
+    uint64_t elapsed = bench::nowNs() - start;
+    uint64_t allocations = bench::allocations() - allocationsBefore;
+    processor.stop();
+    report.add("tickprocessor_ticks_per_s",
+               static_cast<double>(ticks.size()) * 1e9 / static_cast<double>(elapsed));
+    report.addStage("tickprocessor", latency, allocations);
+}
+
+void benchMarket(bench::Report &report, std::span<const TickRecord> ticks,
+                 const std::vector<uint32_t> &ids) {
+    measureOps(
+        report, "market", ticks, ids, []() { return std::make_unique<MarketDataProcessor>(); },
+        [](MarketDataProcessor &market, const TickRecord &tick, uint32_t) {
+            SymbolId id = market.registerSymbol(tick);
+            market.processTick(id, tick.timestampMs(), tick.price(), tick.volume);
+            (void)market.isAnomaly(id, tick.price());
+        });
+
+    // The replay path: the whole stream in one processTicks call
+    MarketDataProcessor batch;
+    uint64_t start = bench::nowNs();
+    batch.processTicks(ticks);
+    report.add("market_batch_ticks_per_s", static_cast<double>(ticks.size()) * 1e9 /
+                                               static_cast<double>(bench::nowNs() - start));
+}
+
+void benchVWAP(bench::Report &report, std::span<const TickRecord> ticks,
+               const std::vector<uint32_t> &ids, size_t symbols) {
+    using Calculators = std::vector<VWAPCalculator<>>;
+    measureOps(
+        report, "vwap", ticks, ids, [&]() { return std::make_unique<Calculators>(symbols); },
+        [](Calculators &vwaps, const TickRecord &tick, uint32_t id) { vwaps[id].addTick(tick); });
+
+    // One calculator over the whole stream through the chunked record path
+    VWAPCalculator<> batch;
+    uint64_t start = bench::nowNs();
+    batch.addTicks(ticks);
+    report.add("vwap_batch_ticks_per_s", static_cast<double>(ticks.size()) * 1e9 /
+                                             static_cast<double>(bench::nowNs() - start));
+}
+
+// Per-symbol books fed by TickOrderFlow, in map mode and on ladders over each symbol's range
+void benchBook(bench::Report &report, std::span<const TickRecord> ticks,
+               const std::vector<uint32_t> &ids, size_t symbols) {
+    using Book = BasicOrderBook<bench::RejectCounter>;
+    struct Books {
+        std::vector<std::unique_ptr<Book>> books;
+        bench::TickOrderFlow flow;
+    };
+    std::vector<bench::PriceBand> bands = bench::priceBands(ticks, ids, symbols);
+    for (bool ladder : {false, true}) {
+        uint64_t rejects = 0;
+        auto make = [&]() {
+            rejects = 0;
+            auto state = std::make_unique<Books>();
+            for (size_t k = 0; k < symbols; ++k) {
+                bench::RejectCounter counter(rejects);
+                state->books.push_back(ladder ? std::make_unique<Book>(bench::LADDER_TICK,
+                                                                       bands[k].low,
+                                                                       bands[k].high, counter)
+                                              : std::make_unique<Book>(counter));
+                state->books.back()->reserve(2 * bench::TickOrderFlow::LIVE);
+            }
+            return state;
+        };
+        std::string name = ladder ? "book_ladder" : "book_map";
+        measureOps(report, name, ticks, ids, make,
+                   [](Books &state, const TickRecord &tick, uint32_t id) {
+                       state.flow.apply(*state.books[id], id, tick);
+                   });
+        report.add(name + "_rejects_count", static_cast<double>(rejects));
+    }
+}
+
+// Reference-data lookups keyed by symbol code through each cache flavour
+void benchCache(bench::Report &report, std::span<const TickRecord> ticks,
+                const std::vector<uint32_t> &ids, size_t entries) {
+    auto load = [](uint64_t symbol) { return bench::loadRefData(symbol); };
+    auto missRatio = [](uint64_t hits, uint64_t misses) {
+        return static_cast<double>(misses) /
+               static_cast<double>(std::max<uint64_t>(1, hits + misses));
+    };
+
+    using Lru = LRUCache<uint64_t, bench::RefData>;
+    using TinyLfu = TinyLFUCache<uint64_t, bench::RefData>;
+    uint64_t hits = 0, misses = 0;
+    measureOps(
+        report, "cache_lru", ticks, ids, [&]() { return std::make_unique<Lru>(entries); },
+        [&](Lru &cache, const TickRecord &tick, uint32_t) {
+            cache.get_or_compute(tick.symbol, [&]() { return load(tick.symbol); });
+            hits = cache.hits();
+            misses = cache.misses();
+        });
+    report.add("cache_lru_miss_ratio", missRatio(hits, misses));
+
+    measureOps(
+        report, "cache_tinylfu", ticks, ids, [&]() { return std::make_unique<TinyLfu>(entries); },
+        [&](TinyLfu &cache, const TickRecord &tick, uint32_t) {
+            cache.get_or_compute(tick.symbol, [&]() { return load(tick.symbol); });
+            hits = cache.hits();
+            misses = cache.misses();
+        });
+    report.add("cache_tinylfu_miss_ratio", missRatio(hits, misses));
+
+    using Flat = FlatLRUCache<uint64_t, bench::RefData>;
+    hits = misses = 0;
+    measureOps(
+        report, "cache_flat", ticks, ids, [&]() {
+            hits = misses = 0;
+            return std::make_unique<Flat>(entries);
+        },
+        [&](Flat &cache, const TickRecord &tick, uint32_t) {
+            if (cache.get(tick.symbol)) {
+                hits++;
+            } else {
+                misses++;
+                cache.put(tick.symbol, load(tick.symbol));
+            }
+        });
+    report.add("cache_flat_miss_ratio", missRatio(hits, misses));
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::CommonOptions options;
+    std::string component = "all";
+    size_t cacheEntries = 0; // 0 means half the symbols
+    size_t queueCapacity = 65536;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            std::string v;
+            if (options.parse(arg)) continue;
+            if (!(v = bench::argValue(arg, "component")).empty()) {
+                component = v;
+            } else if (!(v = bench::argValue(arg, "cache")).empty()) {
+                cacheEntries = std::stoull(v);
+            } else if (!(v = bench::argValue(arg, "queue")).empty()) {
+                queueCapacity = std::stoull(v);
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+        const std::vector<std::string> known = {"queue", "tickprocessor", "market", "vwap",
+                                                "book",  "cache",         "all"};
+        if (std::find(known.begin(), known.end(), component) == known.end()) {
+            throw std::invalid_argument("Unknown component " + component);
+        }
+
+        bench::TickStream stream = options.load();
+        std::span<const TickRecord> ticks = stream.ticks();
+        size_t symbols = 0;
+        std::vector<uint32_t> ids = bench::symbolIndices(ticks, symbols);
+        if (!cacheEntries) cacheEntries = std::max<size_t>(1, symbols / 2);
+
+        bench::Report report("component-" + component);
+        options.describe(report);
+        report.setConfig("ticks", std::to_string(ticks.size()));
+        report.setConfig("symbols_seen", std::to_string(symbols));
+        report.setConfig("cache", std::to_string(cacheEntries));
+        report.setConfig("queue", std::to_string(queueCapacity));
+
+        auto selected = [&](const std::string &name) {
+            return component == "all" || component == name;
+        };
+        if (selected("queue")) {
+            benchQueue<MutexPolicy>(report, "queue_mutex", ticks, options.stream, queueCapacity);
+            benchQueue<LockFreePolicy>(report, "queue_lockfree", ticks, options.stream,
+                                       queueCapacity);
+        }
+        if (selected("tickprocessor")) benchTickProcessor(report, ticks, options.stream);
+        if (selected("market")) benchMarket(report, ticks, ids);
+        if (selected("vwap")) benchVWAP(report, ticks, ids, symbols);
+        if (selected("book")) benchBook(report, ticks, ids, symbols);
+        if (selected("cache")) benchCache(report, ticks, ids, cacheEntries);
+        return options.finish(report);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
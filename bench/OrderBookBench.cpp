@@ -0,0 +1,306 @@
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../include/LatencyHistogram.hpp"
+#include "../include/OrderBook.hpp"
+#include "AllocationCounter.hpp"
+
+// Order-flow replay benchmark for OrderBook.
+//
+//   OrderBookBench [--book=ladder|map] [--ops=N] [--seed=S] [--cancel=F] [--modify=F]
+//                  [--cross=F] [--mid=P] [--tick=T] [--depth=TICKS] [--max-qty=Q]
+//                  [--reserve=N] [--record=FILE] [--replay=FILE]
+//
+// Ratios are fractions of all operations; whatever is left over is passive adds. A flow can be
+// written with --record and fed back with --replay, one operation per line:
+//   A <B|S> <price> <qty> <id>    add
+//   C <id>                        cancel
+//   M <id> <qty>                  modify
+
+namespace {
+
+struct FlowOp {
+    enum Type { ADD, CANCEL, MODIFY };
+
+    Type type;
+    OrderBookTypes::Side side;
+    double price;
+    int quantity;
+    int orderID;
+};
+
+struct FlowConfig {
+    uint64_t seed = 42;
+    size_t operations = 1000000;
+    double cancelRatio = 0.45;
+    double modifyRatio = 0.05;
+    double crossRatio = 0.05;
+    double mid = 100.0;
+    double tickSize = 0.01;
+    int depthTicks = 20; // Mean distance of passive orders from the mid
+    int maxQuantity = 100;
+};
+
+// Deterministic synthetic flow: passive orders at a geometric distance from a random-walking
+// mid, aggressive orders a few ticks through it, and cancels/modifies of random live orders
+std::vector<FlowOp> generateFlow(const FlowConfig &config) {
+    std::mt19937_64 rng(config.seed);
+    std::uniform_real_distribution<double> unit(0.0, 1.0);
+    std::geometric_distribution<int> distance(1.0 / config.depthTicks);
+    std::uniform_int_distribution<int> quantity(1, config.maxQuantity);
+    std::uniform_int_distribution<int> crossTicks(1, 5);
+
+    double ticksPerUnit = 1.0 / config.tickSize;
+    long long midTick = std::llround(config.mid * ticksPerUnit);
+    auto price = [ticksPerUnit](long long tick) {
+        return static_cast<double>(tick) / ticksPerUnit;
+    };
+
+    std::vector<FlowOp> flow;
+    flow.reserve(config.operations);
+    std::vector<int> live;
+    int nextID = 1;
+
+    for (size_t i = 0; i < config.operations; ++i) {
+        if (unit(rng) < 0.01) midTick += unit(rng) < 0.5 ? -1 : 1;
+
+        double r = unit(rng);
+        OrderBookTypes::Side side = unit(rng) < 0.5 ? OrderBookTypes::BUY : OrderBookTypes::SELL;
+        if (r < config.cancelRatio && !live.empty()) {
+            size_t pick = rng() % live.size();
+            flow.push_back({FlowOp::CANCEL, side, 0.0, 0, live[pick]});
+            live[pick] = live.back();
+            live.pop_back();
+        } else if (r < config.cancelRatio + config.modifyRatio && !live.empty()) {
+            flow.push_back({FlowOp::MODIFY, side, 0.0, quantity(rng), live[rng() % live.size()]});
+        } else if (r < config.cancelRatio + config.modifyRatio + config.crossRatio) {
+            long long tick = side == OrderBookTypes::BUY ? midTick + crossTicks(rng)
+                                                         : midTick - crossTicks(rng);
+            flow.push_back({FlowOp::ADD, side, price(tick), quantity(rng) * 5, nextID++});
+        } else {
+            long long offset = 1 + distance(rng);
+            long long tick = side == OrderBookTypes::BUY ? midTick - offset : midTick + offset;
+            flow.push_back({FlowOp::ADD, side, price(tick), quantity(rng), nextID});
+            live.push_back(nextID++);
+        }
+    }
+    return flow;
+}
+
+void recordFlow(const std::vector<FlowOp> &flow, const std::string &path) {
+    std::ofstream out(path);
+    if (!out) throw std::runtime_error("Cannot write " + path);
+    out << std::setprecision(17);
+    for (const auto &op : flow) {
+        switch (op.type) {
+        case FlowOp::ADD:
+            out << "A " << (op.side == OrderBookTypes::BUY ? 'B' : 'S') << ' ' << op.price << ' '
+                << op.quantity << ' ' << op.orderID << '\n';
+            break;
+        case FlowOp::CANCEL:
+            out << "C " << op.orderID << '\n';
+            break;
+        case FlowOp::MODIFY:
+            out << "M " << op.orderID << ' ' << op.quantity << '\n';
+            break;
+        }
+    }
+}
+
+std::vector<FlowOp> replayFlow(const std::string &path) {
+    std::ifstream in(path);
+    if (!in) throw std::runtime_error("Cannot read " + path);
+    std::vector<FlowOp> flow;
+    char type;
+    while (in >> type) {
+        FlowOp op{FlowOp::ADD, OrderBookTypes::BUY, 0.0, 0, 0};
+        if (type == 'A') {
+            char side;
+            in >> side >> op.price >> op.quantity >> op.orderID;
+            op.side = side == 'B' ? OrderBookTypes::BUY : OrderBookTypes::SELL;
+        } else if (type == 'C') {
+            op.type = FlowOp::CANCEL;
+            in >> op.orderID;
+        } else if (type == 'M') {
+            op.type = FlowOp::MODIFY;
+            in >> op.orderID >> op.quantity;
+        } else {
+            throw std::runtime_error(std::string("Bad flow record type: ") + type);
+        }
+        if (!in) throw std::runtime_error("Truncated flow record in " + path);
+        flow.push_back(op);
+    }
+    return flow;
+}
+
+// Counts reports so the benchmark can tell a resting add from one that traded
+struct CountingSink : OrderBookTypes {
+    uint64_t trades = 0;
+    uint64_t acks = 0;
+    uint64_t cancels = 0;
+    uint64_t rejects = 0;
+
+    void onTrade(const Trade &) {
+        trades++;
+    }
+    void onAck(const Ack &) {
+        acks++;
+    }
+    void onCancel(const Cancel &) {
+        cancels++;
+    }
+    void onReject(const Reject &) {
+        rejects++;
+    }
+};
+
+using BenchBook = BasicOrderBook<CountingSink>;
+
+void apply(BenchBook &book, const FlowOp &op) {
+    switch (op.type) {
+    case FlowOp::ADD:
+        book.addOrder(op.side, op.price, op.quantity, op.orderID);
+        break;
+    case FlowOp::CANCEL:
+        book.cancelOrder(op.orderID);
+        break;
+    case FlowOp::MODIFY:
+        book.modifyOrder(op.orderID, op.quantity);
+        break;
+    }
+}
+
+struct OpStats {
+    const char *name;
+    LatencyHistogram latency;
+    uint64_t allocations = 0;
+};
+
+void printRow(const OpStats &stats) {
+    const LatencyHistogram &h = stats.latency;
+    double allocsPerOp =
+        h.count() ? static_cast<double>(stats.allocations) / static_cast<double>(h.count()) : 0.0;
+    std::cout << std::left << std::setw(8) << stats.name << std::right << std::setw(10)
+              << h.count() << std::setw(9) << h.percentile(0.50) << std::setw(9)
+              << h.percentile(0.99) << std::setw(9) << h.percentile(0.999) << std::setw(10)
+              << h.max() << std::setw(12) << std::fixed << std::setprecision(3) << allocsPerOp
+              << std::endl;
+}
+
+std::string argValue(const std::string &arg, const std::string &key) {
+    std::string prefix = "--" + key + "=";
+    return arg.compare(0, prefix.size(), prefix) == 0 ? arg.substr(prefix.size()) : std::string();
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    FlowConfig config;
+    std::string bookType = "ladder";
+    std::string recordPath;
+    std::string replayPath;
+    size_t reserve = 0;
+
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        std::string v;
+        if (!(v = argValue(arg, "book")).empty()) bookType = v;
+        else if (!(v = argValue(arg, "ops")).empty()) config.operations = std::stoull(v);
+        else if (!(v = argValue(arg, "seed")).empty()) config.seed = std::stoull(v);
+        else if (!(v = argValue(arg, "cancel")).empty()) config.cancelRatio = std::stod(v);
+        else if (!(v = argValue(arg, "modify")).empty()) config.modifyRatio = std::stod(v);
+        else if (!(v = argValue(arg, "cross")).empty()) config.crossRatio = std::stod(v);
+        else if (!(v = argValue(arg, "mid")).empty()) config.mid = std::stod(v);
+        else if (!(v = argValue(arg, "tick")).empty()) config.tickSize = std::stod(v);
+        else if (!(v = argValue(arg, "depth")).empty()) config.depthTicks = std::stoi(v);
+        else if (!(v = argValue(arg, "max-qty")).empty()) config.maxQuantity = std::stoi(v);
+        else if (!(v = argValue(arg, "reserve")).empty()) reserve = std::stoull(v);
+        else if (!(v = argValue(arg, "record")).empty()) recordPath = v;
+        else if (!(v = argValue(arg, "replay")).empty()) replayPath = v;
+        else {
+            std::cerr << "Unknown argument: " << arg << std::endl;
+            return 1;
+        }
+    }
+    if (bookType != "ladder" && bookType != "map") {
+        std::cerr << "--book must be ladder or map" << std::endl;
+        return 1;
+    }
+
+    std::vector<FlowOp> flow = replayPath.empty() ? generateFlow(config) : replayFlow(replayPath);
+    if (!recordPath.empty()) recordFlow(flow, recordPath);
+
+    // Ladder band wide enough for the random walk of the mid
+    auto makeBook = [&]() {
+        if (bookType == "map") return BenchBook();
+        return BenchBook(config.tickSize, config.mid * 0.5, config.mid * 1.5);
+    };
+
+    std::cout << "=== OrderBook replay benchmark ===" << std::endl;
+    std::cout << "book=" << bookType << " ops=" << flow.size()
+              << (replayPath.empty() ? " source=synthetic seed=" + std::to_string(config.seed)
+                                     : " source=" + replayPath)
+              << std::endl;
+
+    // Pass 1: throughput, no per-operation instrumentation
+    {
+        BenchBook book = makeBook();
+        if (reserve) book.reserve(reserve);
+        auto start = std::chrono::steady_clock::now();
+        for (const auto &op : flow) {
+            apply(book, op);
+        }
+        auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+        const CountingSink &sink = book.sink();
+        std::cout << "Throughput: " << std::fixed << std::setprecision(0)
+                  << static_cast<double>(flow.size()) / elapsed.count() << " ops/s ("
+                  << std::setprecision(3) << elapsed.count() * 1e3 << " ms)" << std::endl;
+        std::cout << "Reports: trades=" << sink.trades << " acks=" << sink.acks
+                  << " cancels=" << sink.cancels << " rejects=" << sink.rejects << std::endl;
+    }
+
+    // Pass 2: per-operation latency and allocations on a fresh book
+    OpStats add{"add", {}, 0};
+    OpStats match{"match", {}, 0};
+    OpStats cancel{"cancel", {}, 0};
+    OpStats modify{"modify", {}, 0};
+    {
+        BenchBook book = makeBook();
+        if (reserve) book.reserve(reserve);
+        for (const auto &op : flow) {
+            uint64_t tradesBefore = book.sink().trades;
+            uint64_t allocsBefore = bench::allocations();
+            auto t0 = std::chrono::steady_clock::now();
+            apply(book, op);
+            auto t1 = std::chrono::steady_clock::now();
+            uint64_t allocs = bench::allocations() - allocsBefore;
+            uint64_t ns = static_cast<uint64_t>(
+                std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count());
+
+            OpStats &stats = op.type == FlowOp::CANCEL   ? cancel
+                             : op.type == FlowOp::MODIFY ? modify
+                             : book.sink().trades != tradesBefore ? match
+                                                                  : add;
+            stats.latency.record(ns);
+            stats.allocations += allocs;
+        }
+    }
+
+    std::cout << "\nLatency (ns, includes ~20ns clock overhead)" << std::endl;
+    std::cout << std::left << std::setw(8) << "op" << std::right << std::setw(10) << "count"
+              << std::setw(9) << "p50" << std::setw(9) << "p99" << std::setw(9) << "p99.9"
+              << std::setw(10) << "max" << std::setw(12) << "allocs/op" << std::endl;
+    for (const OpStats *stats : {&add, &match, &cancel, &modify}) {
+        printRow(*stats);
+    }
+
+    return 0;
+}
@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/CircularBuffer.hpp"
+#include "../include/LRUCache.hpp"
+#include "../include/LatencyHistogram.hpp"
+#include "../include/MarketDataProcessor.hpp"
+#include "../include/OrderBook.hpp"
+#include "../include/ThreadSafeQueue.hpp"
+#include "../include/TickProcessor.hpp"
+#include "../include/TickRecord.hpp"
+#include "../include/VWAPCalculator.hpp"
+#include "AllocationCounter.hpp"
+#include "BenchSupport.hpp"
+
+// End-to-end market-data pipeline benchmark. A feed thread sends the stream at the configured
+// rate into a ThreadSafeQueue; the pipeline thread takes each tick through reference-data
+// lookup (LRUCache), MarketDataProcessor statistics and anomaly check, a per-symbol
+// VWAPCalculator and OrderBook, and hands it to a TickProcessor for the published VWAPs.
+//
+//   PipelineBench [--ticks=N] [--symbols=N] [--seed=S] [--skew=Z] [--rate=TICKS_PER_S]
+//                 [--burst=N] [--replay=FILE] [--record=FILE] [--book=map|ladder]
+//                 [--cache=ENTRIES] [--queue=CAPACITY] [--workers=N] [--vwap-window=N]
+//                 [--json=FILE|-] [--baseline=FILE] [--tolerance=FRACTION]
+//
+// Every stage is timed per tick with the steady clock, so stage latencies include its ~20 ns
+// read. queue is send-to-receive and total is send-to-handoff; without --rate the feed
+// outruns the pipeline, so both measure the queue's backlog and only throughput is meaningful.
+// --book=ladder gives each symbol a cent ladder over its price range in the stream;
+// book_rejects_count shows any adds a book turned away. Allocations are process-wide,
+// counted across each stage on the pipeline thread. Exits with 3 if --baseline shows a
+// regression beyond --tolerance (default 5%).
+
+namespace {
+
+struct SentTick {
+    TickRecord tick;
+    uint64_t sentNs;
+};
+
+struct PipelineConfig {
+    bool ladder = false;
+    size_t cacheEntries = 0; // 0 means half the stream's symbols, so the cache has to evict
+    size_t queueCapacity = 65536;
+    size_t workers = 1;
+    int vwapWindow = 100;
+};
+
+enum Stage { QUEUE, REFDATA, MARKET, VWAP, BOOK, PUBLISH, TOTAL, STAGES };
+
+const char *stageName(int stage) {
+    static const char *names[STAGES] = {"queue", "refdata", "market", "vwap",
+                                        "book",  "publish", "total"};
+    return names[stage];
+}
+
+using Book = BasicOrderBook<bench::RejectCounter>;
+
+// Shuts the queue and joins the feed if the pipeline leaves early, e.g. by exception, so the
+// feed neither blocks on a full queue nor outlives the stream it reads
+template <typename Queue> struct FeedGuard {
+    Queue &queue;
+    std::thread &feed;
+
+    ~FeedGuard() {
+        if (feed.joinable()) {
+            queue.shutdown();
+            feed.join();
+        }
+    }
+};
+
+template <typename Queue>
+void runPipeline(std::span<const TickRecord> ticks, const bench::StreamConfig &stream,
+                 const PipelineConfig &config, const std::vector<bench::PriceBand> &bands,
+                 Queue &queue, bench::Report &report) {
+    LRUCache<uint64_t, bench::RefData> refData(config.cacheEntries);
+    MarketDataProcessor market;
+    std::vector<VWAPCalculator<>> vwaps;
+    std::vector<std::unique_ptr<Book>> books;
+    bench::TickOrderFlow flow;
+    TickProcessor<SpscQueue<Tick, 65536, SpinPark>> publisher(config.workers);
+
+    LatencyHistogram latency[STAGES];
+    uint64_t allocations[STAGES] = {};
+    size_t anomalies = 0;
+    size_t breaches = 0;
+    uint64_t rejects = 0;
+
+    publisher.start();
+    bench::Pacer pacer(stream.rate, stream.burst);
+    std::thread feed([&]() {
+        pacer.start();
+        try {
+            for (size_t i = 0; i < ticks.size(); ++i) {
+                pacer.wait(i);
+                queue.push({ticks[i], bench::nowNs()});
+            }
+        } catch (const std::runtime_error &) {
+            // The pipeline shut the queue down early
+        }
+    });
+    FeedGuard<Queue> guard{queue, feed};
+
+    uint64_t allocationsBefore = bench::allocations();
+    uint64_t start = bench::nowNs();
+    for (size_t i = 0; i < ticks.size(); ++i) {
+        SentTick sent = queue.pop();
+        const TickRecord &tick = sent.tick;
+        uint64_t stamps[STAGES + 1];
+        uint64_t allocs[STAGES + 1];
+        stamps[0] = bench::nowNs();
+        allocs[0] = bench::allocations();
+        auto mark = [&](int stage) {
+            stamps[stage + 1] = bench::nowNs();
+            allocs[stage + 1] = bench::allocations();
+        };
+        mark(QUEUE);
+
+        const bench::RefData *ref =
+            refData.get_or_compute(tick.symbol, [&]() { return bench::loadRefData(tick.symbol); });
+        breaches += ref && tick.price() * tick.volume > ref->maxNotional;
+        mark(REFDATA);
+
+        SymbolId id = market.registerSymbol(tick);
+        market.processTick(id, tick.timestampMs(), tick.price(), tick.volume);
+        anomalies += market.isAnomaly(id, tick.price());
+        mark(MARKET);
+
+        if (id >= vwaps.size()) vwaps.resize(id + 1, VWAPCalculator<>(config.vwapWindow));
+        vwaps[id].addTick(tick);
+        mark(VWAP);
+
+        // A fresh processor numbers symbols by first appearance, as priceBands() does
+        if (id >= books.size()) {
+            books.resize(id + 1);
+            bench::RejectCounter counter(rejects);
+            books[id] = config.ladder ? std::make_unique<Book>(bench::LADDER_TICK, bands[id].low,
+                                                               bands[id].high, counter)
+                                      : std::make_unique<Book>(counter);
+            books[id]->reserve(2 * bench::TickOrderFlow::LIVE);
+        }
+        flow.apply(*books[id], id, tick);
+        mark(BOOK);
+
+        publisher.addTick(tick);
+        mark(PUBLISH);
+
+        // stamps[s + 1] closes stage s; the queue stage starts at the send
+        latency[QUEUE].record(stamps[1] - sent.sentNs);
+        for (int stage = REFDATA; stage < TOTAL; ++stage) {
+            latency[stage].record(stamps[stage + 1] - stamps[stage]);
+            allocations[stage] += allocs[stage + 1] - allocs[stage];
+        }
+        latency[TOTAL].record(stamps[PUBLISH + 1] - sent.sentNs);
+        allocations[TOTAL] += allocs[PUBLISH + 1] - allocs[0];
+    }
+    uint64_t pipelineEnd = bench::nowNs();
+    uint64_t pipelineAllocations = bench::allocations() - allocationsBefore;
+    feed.join();
+    while (publisher.getProcessedCount() < static_cast<int>(ticks.size())) {
+        std::this_thread::yield();
+    }
+    uint64_t drainedEnd = bench::nowNs();
+    publisher.stop();
+
+    double n = static_cast<double>(ticks.size());
+    report.add("ticks_count", n);
+    report.add("throughput_ticks_per_s", n * 1e9 / static_cast<double>(drainedEnd - start));
+    report.add("pipeline_ticks_per_s", n * 1e9 / static_cast<double>(pipelineEnd - start));
+    report.add("allocs_per_tick", static_cast<double>(pipelineAllocations) / n);
+    report.add("refdata_miss_ratio",
+               static_cast<double>(refData.misses()) /
+                   static_cast<double>(std::max<uint64_t>(1, refData.hits() + refData.misses())));
+    report.add("anomalies_count", static_cast<double>(anomalies));
+    report.add("notional_breaches_count", static_cast<double>(breaches));
+    report.add("book_rejects_count", static_cast<double>(rejects));
+    for (int stage = 0; stage < STAGES; ++stage) {
+        report.addStage(stageName(stage), latency[stage], allocations[stage]);
+    }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+    bench::CommonOptions options;
+    PipelineConfig config;
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            std::string v;
+            if (options.parse(arg)) continue;
+            if (!(v = bench::argValue(arg, "book")).empty()) {
+                if (v != "map" && v != "ladder") throw std::invalid_argument("Unknown book " + v);
+                config.ladder = v == "ladder";
+            } else if (!(v = bench::argValue(arg, "cache")).empty()) {
+                config.cacheEntries = std::stoull(v);
+            } else if (!(v = bench::argValue(arg, "queue")).empty()) {
+                config.queueCapacity = std::stoull(v);
+            } else if (!(v = bench::argValue(arg, "workers")).empty()) {
+                config.workers = std::stoull(v);
+            } else if (!(v = bench::argValue(arg, "vwap-window")).empty()) {
+                config.vwapWindow = std::stoi(v);
+            } else {
+                throw std::invalid_argument("Unknown option " + arg);
+            }
+        }
+
+        bench::TickStream stream = options.load();
+        size_t symbols = 0;
+        std::vector<uint32_t> ids = bench::symbolIndices(stream.ticks(), symbols);
+        std::vector<bench::PriceBand> bands = bench::priceBands(stream.ticks(), ids, symbols);
+        if (!config.cacheEntries) config.cacheEntries = std::max<size_t>(1, symbols / 2);
+
+        bench::Report report("pipeline");
+        options.describe(report);
+        report.setConfig("ticks", std::to_string(stream.ticks().size()));
+        report.setConfig("symbols_seen", std::to_string(symbols));
+        report.setConfig("book", config.ladder ? "ladder" : "map");
+        report.setConfig("cache", std::to_string(config.cacheEntries));
+        report.setConfig("workers", std::to_string(config.workers));
+
+        ThreadSafeQueue<SentTick, LockFreePolicy> queue(config.queueCapacity);
+        runPipeline(stream.ticks(), options.stream, config, bands, queue, report);
+        return options.finish(report);
+    } catch (const std::exception &e) {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+}
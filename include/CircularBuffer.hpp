@@ -0,0 +1,218 @@
+#ifndef CIRCULARBUFFER_HPP
+#define CIRCULARBUFFER_HPP
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+// Tell the CPU we are in a spin loop (frees pipeline resources for a sibling hyperthread)
+inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+// Lock-free single-producer single-consumer ring of Size slots (a power of two). Head and tail
+// are monotonic counters on separate cache lines, and each side keeps a private copy of the
+// other side's counter so it only touches the shared line when the ring looks full or empty.
+template <typename T, size_t Size> class CircularBuffer {
+    static_assert(Size >= 2 && (Size & (Size - 1)) == 0, "Size must be a power of two");
+
+  public:
+    CircularBuffer() = default;
+
+    CircularBuffer(const CircularBuffer &) = delete;
+    CircularBuffer &operator=(const CircularBuffer &) = delete;
+
+    // Write (producer); returns false if full
+    bool write(const T &item) {
+        return emplace(item);
+    }
+
+    bool write(T &&item) {
+        return emplace(std::move(item));
+    }
+
+    // Read (consumer); returns false if empty
+    bool read(T &item) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) return false;
+        }
+        item = std::move(slots_[head & MASK]);
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // States, exact only when called from the producer or consumer thread
+    bool empty() const {
+        return size() == 0;
+    }
+
+    bool full() const {
+        return size() == Size;
+    }
+
+    size_t size() const {
+        // Head first: tail can only have moved further by the time it is read
+        size_t head = head_.load(std::memory_order_acquire);
+        size_t tail = tail_.load(std::memory_order_acquire);
+        return tail - head;
+    }
+
+    static constexpr size_t capacity() {
+        return Size;
+    }
+
+  private:
+    static constexpr size_t MASK = Size - 1;
+
+    template <typename U> bool emplace(U &&item) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ == Size) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ == Size) return false;
+        }
+        slots_[tail & MASK] = std::forward<U>(item);
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer's line
+    alignas(64) std::atomic<size_t> head_{0};
+    size_t cachedTail_ = 0;
+
+    // Producer's line
+    alignas(64) std::atomic<size_t> tail_{0};
+    size_t cachedHead_ = 0;
+
+    alignas(64) std::array<T, Size> slots_{};
+};
+
+// Wait policies for SpscQueue's consumer. waitUntil(ready, deadline) returns true as soon as
+// ready() does, or false at the deadline; notify() is called by the producer after each write.
+
+// Spin on the ring: lowest latency, but the consumer burns its core while idle
+struct BusySpin {
+    template <typename Ready>
+    bool waitUntil(Ready &&ready, std::chrono::steady_clock::time_point deadline) {
+        for (uint32_t spins = 1;; ++spins) {
+            if (ready()) return true;
+            if ((spins & 1023) == 0 && std::chrono::steady_clock::now() >= deadline) {
+                return ready();
+            }
+            cpuRelax();
+        }
+    }
+
+    void notify() {}
+};
+
+// Spin briefly, then yield the core between checks
+struct SpinYield {
+    static constexpr int SPINS = 256;
+
+    template <typename Ready>
+    bool waitUntil(Ready &&ready, std::chrono::steady_clock::time_point deadline) {
+        for (int i = 0; i < SPINS; ++i) {
+            if (ready()) return true;
+            cpuRelax();
+        }
+        while (std::chrono::steady_clock::now() < deadline) {
+            if (ready()) return true;
+            std::this_thread::yield();
+        }
+        return ready();
+    }
+
+    void notify() {}
+};
+
+// Spin briefly, then sleep on a condition variable. The consumer raises parked_ before its last
+// check, and the producer only takes the lock to wake it when it sees the flag, so a push to a
+// busy consumer costs one fence and one load.
+class SpinPark {
+  public:
+    static constexpr int SPINS = 256;
+
+    template <typename Ready>
+    bool waitUntil(Ready &&ready, std::chrono::steady_clock::time_point deadline) {
+        for (int i = 0; i < SPINS; ++i) {
+            if (ready()) return true;
+            cpuRelax();
+        }
+        std::unique_lock<std::mutex> lock(mutex_);
+        parked_.store(true, std::memory_order_relaxed);
+        // Pairs with the fence in notify(): either the producer sees parked_ or we see its item
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        bool woken = wakeup_.wait_until(lock, deadline, ready);
+        parked_.store(false, std::memory_order_relaxed);
+        return woken;
+    }
+
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed)) {
+            std::lock_guard<std::mutex> lock(mutex_);
+            wakeup_.notify_one();
+        }
+    }
+
+  private:
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    std::atomic<bool> parked_{false};
+};
+
+// Blocking SPSC queue on a CircularBuffer: push spins (yielding) while the ring is full, and
+// the consumer waits according to WaitPolicy. Exactly one thread may push and one may pop.
+template <typename T, size_t Size, typename WaitPolicy = SpinYield> class SpscQueue {
+  public:
+    void push(T item) {
+        while (!buffer_.write(std::move(item))) {
+            std::this_thread::yield();
+        }
+        wait_.notify();
+    }
+
+    // Non-blocking version (returns false if full)
+    bool tryPush(T item) {
+        if (!buffer_.write(std::move(item))) return false;
+        wait_.notify();
+        return true;
+    }
+
+    bool tryPop(T &item) {
+        return buffer_.read(item);
+    }
+
+    template <typename Rep, typename Period>
+    bool waitAndPop(T &item, const std::chrono::duration<Rep, Period> &timeout) {
+        if (buffer_.read(item)) return true;
+        return wait_.waitUntil([this, &item]() { return buffer_.read(item); },
+                               std::chrono::steady_clock::now() + timeout);
+    }
+
+    bool empty() const {
+        return buffer_.empty();
+    }
+
+    size_t size() const {
+        return buffer_.size();
+    }
+
+  private:
+    CircularBuffer<T, Size> buffer_;
+    WaitPolicy wait_;
+};
+
+#endif
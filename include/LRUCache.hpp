@@ -0,0 +1,860 @@
+#ifndef LRUCACHE_HPP
+#define LRUCACHE_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Hash for std::string keys that also accepts std::string_view and C strings, so lookups can
+// probe a string-keyed cache without building a temporary std::string. Pair it with
+// std::equal_to<> as the KeyEqual.
+struct TransparentStringHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view s) const {
+        return std::hash<std::string_view>{}(s);
+    }
+};
+
+// Default weigher: every entry weighs 1, so capacity is an entry count
+struct UnitWeigher {
+    template <typename K, typename V> size_t operator()(const K &, const V &) const {
+        return 1;
+    }
+};
+
+// Plain LRU: every new key is admitted and the least recently used entry is evicted
+struct LruPolicy {
+    static constexpr bool admission = false;
+
+    explicit LruPolicy(size_t) {}
+};
+
+// W-TinyLFU: new entries land in a small LRU window. When the window overflows, its oldest entry
+// only enters the main cache if it has been requested more often than the entry main would evict.
+// Request counts come from a count-min sketch of 4-bit counters that are halved periodically, so
+// old popularity fades. Main is a segmented LRU: a second hit promotes an entry from probation to
+// protected.
+class TinyLfuPolicy {
+  public:
+    static constexpr bool admission = true;
+    static constexpr double WINDOW_FRACTION = 0.01;
+    static constexpr double PROTECTED_FRACTION = 0.8;
+
+    // The sketch gets one counter per expected entry in each row
+    explicit TinyLfuPolicy(size_t expectedEntries) {
+        size_t width = 64;
+        unsigned bits = 6;
+        while (width < expectedEntries && bits < 24) {
+            width <<= 1;
+            bits++;
+        }
+        shift_ = 64 - bits;
+        wordsPerRow_ = width / COUNTERS_PER_WORD;
+        table_.assign(DEPTH * wordsPerRow_, 0);
+        sampleSize_ = 10 * width;
+    }
+
+    void recordAccess(uint64_t hash) {
+        bool added = false;
+        for (size_t row = 0; row < DEPTH; ++row) {
+            auto [word, shift] = counterOf(row, hash);
+            if (((table_[word] >> shift) & 0xF) < 15) {
+                table_[word] += uint64_t{1} << shift;
+                added = true;
+            }
+        }
+        if (added && ++additions_ >= sampleSize_) age();
+    }
+
+    unsigned frequency(uint64_t hash) const {
+        unsigned estimate = 15;
+        for (size_t row = 0; row < DEPTH; ++row) {
+            auto [word, shift] = counterOf(row, hash);
+            estimate = std::min(estimate, static_cast<unsigned>((table_[word] >> shift) & 0xF));
+        }
+        return estimate;
+    }
+
+  private:
+    static constexpr size_t DEPTH = 4;
+    static constexpr size_t COUNTERS_PER_WORD = 16;
+    static constexpr uint64_t SEEDS[DEPTH] = {0xC3A5C85C97CB3127ull, 0xB492B66FBE98F273ull,
+                                              0x9AE16A3B2F90404Full, 0xCBF29CE484222325ull};
+
+    std::vector<uint64_t> table_;
+    size_t wordsPerRow_;
+    unsigned shift_;
+    uint64_t additions_ = 0;
+    uint64_t sampleSize_;
+
+    std::pair<size_t, unsigned> counterOf(size_t row, uint64_t hash) const {
+        size_t i = static_cast<size_t>(((hash ^ SEEDS[row]) * 0x9E3779B97F4A7C15ull) >> shift_);
+        return {row * wordsPerRow_ + i / COUNTERS_PER_WORD,
+                static_cast<unsigned>(i % COUNTERS_PER_WORD) * 4};
+    }
+
+    // Halve every counter
+    void age() {
+        for (auto &word : table_) {
+            word = (word >> 1) & 0x7777777777777777ull;
+        }
+        additions_ /= 2;
+    }
+};
+
+// Lookup members accept any type the Hash and KeyEqual accept (heterogeneous lookup when both
+// are transparent). Pointers returned by getPtr/try_emplace/get_or_compute stay valid until that
+// entry is evicted or the cache is cleared.
+//
+// capacity bounds the total weight of the entries, as measured by Weigher(key, value) on insert,
+// put and visit; with UnitWeigher it is an entry count. An entry heavier than the whole capacity
+// is not cached. Policy decides admission and eviction (LruPolicy or TinyLfuPolicy).
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>, typename Policy = LruPolicy,
+          typename Weigher = UnitWeigher>
+class LRUCache {
+  private:
+    // Plain LRU keeps every entry on PROBATION; WINDOW and PROTECTED are for admission policies
+    enum Segment : uint8_t { WINDOW, PROBATION, PROTECTED, SEGMENTS };
+
+    struct Node {
+        Key key;
+        Value value;
+        Node *prev;
+        Node *next;
+        size_t weight;
+        Segment segment;
+
+        template <typename K, typename... Args>
+        explicit Node(K &&k, Args &&...args)
+            : key(std::forward<K>(k)), value(std::forward<Args>(args)...), prev(nullptr),
+              next(nullptr), weight(0), segment(PROBATION) {}
+    };
+
+    struct List {
+        Node *head = nullptr;
+        Node *tail = nullptr;
+        size_t weight = 0;
+    };
+
+    List lists_[SEGMENTS];
+    std::unordered_map<Key, Node *, Hash, KeyEqual> map_;
+    size_t capacity_;
+    size_t windowCapacity_;
+    size_t protectedCapacity_;
+    size_t weight_;
+    uint64_t hits_;
+    uint64_t misses_;
+    uint64_t evictions_;
+    Weigher weigher_;
+    Policy policy_;
+
+    void detach(Node *n) {
+        if (!n) return;
+        List &list = lists_[n->segment];
+        if (n->prev)
+            n->prev->next = n->next;
+        else
+            list.head = n->next;
+        if (n->next)
+            n->next->prev = n->prev;
+        else
+            list.tail = n->prev;
+        n->prev = nullptr;
+        n->next = nullptr;
+        list.weight -= n->weight;
+    }
+
+    void push_front(Node *n, Segment segment) {
+        if (!n) return;
+        List &list = lists_[segment];
+        n->segment = segment;
+        n->prev = nullptr;
+        n->next = list.head;
+        if (list.head) list.head->prev = n;
+        list.head = n;
+        if (!list.tail) list.tail = n;
+        list.weight += n->weight;
+    }
+
+    template <typename K> uint64_t hashOf(const K &key) const {
+        return static_cast<uint64_t>(map_.hash_function()(key)) * 0x9E3779B97F4A7C15ull;
+    }
+
+    // Recency update for an entry that was just requested
+    void onHit(Node *n) {
+        if constexpr (Policy::admission) {
+            if (n->segment == PROBATION) {
+                detach(n);
+                push_front(n, PROTECTED);
+                while (lists_[PROTECTED].weight > protectedCapacity_ &&
+                       lists_[PROTECTED].tail != n) {
+                    Node *demoted = lists_[PROTECTED].tail;
+                    detach(demoted);
+                    push_front(demoted, PROBATION);
+                }
+                return;
+            }
+        }
+        Segment segment = n->segment;
+        detach(n);
+        push_front(n, segment);
+    }
+
+    // Find key and make it the most recent entry
+    template <typename K> Node *touch(const K &key) {
+        if constexpr (Policy::admission) policy_.recordAccess(hashOf(key));
+        auto it = map_.find(key);
+        if (it == map_.end()) return nullptr;
+        onHit(it->second);
+        return it->second;
+    }
+
+    // touch() for reads, which count towards the hit and miss statistics
+    template <typename K> Node *lookup(const K &key) {
+        Node *n = touch(key);
+        if (n)
+            hits_++;
+        else
+            misses_++;
+        return n;
+    }
+
+    void evict(Node *n) {
+        detach(n);
+        map_.erase(n->key);
+        weight_ -= n->weight;
+        evictions_++;
+        delete n;
+    }
+
+    void reweigh(Node *n) {
+        size_t weight = weigher_(n->key, n->value);
+        lists_[n->segment].weight = lists_[n->segment].weight - n->weight + weight;
+        weight_ = weight_ - n->weight + weight;
+        n->weight = weight;
+    }
+
+    // Least valuable entry other than keep
+    Node *victim(const Node *keep) const {
+        for (Segment segment : {PROBATION, PROTECTED, WINDOW}) {
+            Node *n = lists_[segment].tail;
+            if (n && n != keep) return n;
+        }
+        return nullptr;
+    }
+
+    // Restore the weight budgets; keep (the entry just written) goes last
+    void rebalance(Node *keep) {
+        if constexpr (Policy::admission) {
+            size_t mainCapacity = capacity_ - windowCapacity_;
+            while (lists_[WINDOW].weight > windowCapacity_ && lists_[WINDOW].tail != keep) {
+                Node *candidate = lists_[WINDOW].tail;
+                Node *incumbent = lists_[PROBATION].tail ? lists_[PROBATION].tail
+                                                         : lists_[PROTECTED].tail;
+                size_t mainWeight = lists_[PROBATION].weight + lists_[PROTECTED].weight;
+                if (incumbent && mainWeight + candidate->weight > mainCapacity &&
+                    policy_.frequency(hashOf(candidate->key)) <=
+                        policy_.frequency(hashOf(incumbent->key))) {
+                    evict(candidate);
+                    continue;
+                }
+                // Admitted: the incumbent it beat makes room, never the candidate itself
+                detach(candidate);
+                push_front(candidate, PROBATION);
+                mainWeight += candidate->weight;
+                while (incumbent && mainWeight > mainCapacity) {
+                    mainWeight -= incumbent->weight;
+                    evict(incumbent);
+                    incumbent = lists_[PROBATION].tail != candidate ? lists_[PROBATION].tail
+                                                                    : lists_[PROTECTED].tail;
+                }
+            }
+        }
+        while (weight_ > capacity_) {
+            Node *n = victim(keep);
+            evict(n ? n : keep);
+        }
+    }
+
+    // Reweigh an entry whose value changed; one that now outweighs the cache goes alone
+    void refit(Node *n) {
+        reweigh(n);
+        if (n->weight > capacity_) {
+            evict(n);
+            return;
+        }
+        rebalance(n);
+    }
+
+    // Link a freshly built node, or drop it if it alone outweighs the cache
+    Node *insert(Node *n) {
+        n->weight = weigher_(n->key, n->value);
+        if (n->weight > capacity_) {
+            delete n;
+            return nullptr;
+        }
+        map_.emplace(n->key, n);
+        push_front(n, Policy::admission ? WINDOW : PROBATION);
+        weight_ += n->weight;
+        rebalance(n);
+        return n;
+    }
+
+    template <typename K, typename V> void assign(K &&key, V &&value) {
+        if (capacity_ == 0) return;
+        if (Node *n = touch(key)) {
+            n->value = std::forward<V>(value);
+            refit(n);
+        } else {
+            insert(new Node(std::forward<K>(key), std::forward<V>(value)));
+        }
+    }
+
+  public:
+    // expectedEntries sizes an admission policy's sketch; it defaults to capacity, which is only
+    // right for UnitWeigher
+    explicit LRUCache(size_t capacity, Weigher weigher = Weigher(), size_t expectedEntries = 0)
+        : capacity_(capacity), windowCapacity_(0), protectedCapacity_(0), weight_(0), hits_(0),
+          misses_(0), evictions_(0), weigher_(std::move(weigher)),
+          policy_(expectedEntries ? expectedEntries : capacity) {
+        if constexpr (Policy::admission) {
+            windowCapacity_ = std::min(
+                capacity, std::max<size_t>(1, static_cast<size_t>(capacity *
+                                                                  Policy::WINDOW_FRACTION)));
+            protectedCapacity_ = static_cast<size_t>((capacity - windowCapacity_) *
+                                                     Policy::PROTECTED_FRACTION);
+        }
+    }
+
+    template <typename K> std::optional<Value> get(const K &key) {
+        Node *n = lookup(key);
+        if (!n) return std::nullopt;
+        return n->value;
+    }
+
+    // Pointer to the cached value without copying it, or nullptr on a miss
+    template <typename K> Value *getPtr(const K &key) {
+        Node *n = lookup(key);
+        return n ? &n->value : nullptr;
+    }
+
+    // Call fn(Value &) on a hit; returns whether the key was present. The entry is reweighed
+    // afterwards, and is evicted, alone, if fn made it heavier than the whole cache.
+    template <typename K, typename Fn> bool visit(const K &key, Fn &&fn) {
+        Node *n = lookup(key);
+        if (!n) return false;
+        std::forward<Fn>(fn)(n->value);
+        refit(n);
+        return true;
+    }
+
+    void put(const Key &key, const Value &value) {
+        assign(key, value);
+    }
+
+    void put(Key &&key, Value &&value) {
+        assign(std::move(key), std::move(value));
+    }
+
+    // Build the value in place from args unless key is already cached. Returns the entry and
+    // whether it was inserted; {nullptr, false} when the value cannot be cached at all.
+    template <typename K, typename... Args>
+    std::pair<Value *, bool> try_emplace(K &&key, Args &&...args) {
+        if (capacity_ == 0) return {nullptr, false};
+        if (Node *n = touch(key)) return {&n->value, false};
+        Node *n = insert(new Node(Key(std::forward<K>(key)), std::forward<Args>(args)...));
+        return {n ? &n->value : nullptr, n != nullptr};
+    }
+
+    // Cached value for key, running loader() to produce it on a miss. Returns nullptr only when
+    // the loaded value cannot be cached, in which case it is discarded.
+    template <typename K, typename Loader> Value *get_or_compute(K &&key, Loader &&loader) {
+        if (capacity_ == 0) return nullptr;
+        if (Node *n = lookup(key)) return &n->value;
+        Node *n = insert(new Node(Key(std::forward<K>(key)), std::forward<Loader>(loader)()));
+        return n ? &n->value : nullptr;
+    }
+
+    template <typename K> bool contains(const K &key) const {
+        return map_.find(key) != map_.end();
+    }
+
+    size_t size() const {
+        return map_.size();
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    // Total weight of the cached entries
+    size_t weight() const {
+        return weight_;
+    }
+
+    // Lookups (get, getPtr, visit, get_or_compute) that found or missed their key
+    uint64_t hits() const {
+        return hits_;
+    }
+
+    uint64_t misses() const {
+        return misses_;
+    }
+
+    // Entries removed to make room, including candidates refused admission
+    uint64_t evictions() const {
+        return evictions_;
+    }
+
+    void resetStats() {
+        hits_ = 0;
+        misses_ = 0;
+        evictions_ = 0;
+    }
+
+    void clear() {
+        for (List &list : lists_) {
+            Node *cur = list.head;
+            while (cur) {
+                Node *nxt = cur->next;
+                delete cur;
+                cur = nxt;
+            }
+            list = List();
+        }
+        map_.clear();
+        weight_ = 0;
+    }
+
+    ~LRUCache() {
+        clear();
+    }
+
+    LRUCache(const LRUCache &) = delete;
+    LRUCache &operator=(const LRUCache &) = delete;
+};
+
+// LRUCache with W-TinyLFU admission
+template <typename Key, typename Value, typename Hash = std::hash<Key>,
+          typename KeyEqual = std::equal_to<Key>, typename Weigher = UnitWeigher>
+using TinyLFUCache = LRUCache<Key, Value, Hash, KeyEqual, TinyLfuPolicy, Weigher>;
+
+// Fixed-footprint LRU: all capacity nodes live in one array allocated by the constructor and are
+// linked by 32-bit indices, with unused nodes on a free list. Keys are found through an
+// open-addressing index of node indices, so get/put never allocate. Key and Value must be
+// default-constructible; evicted nodes are reused by assignment.
+template <typename Key, typename Value, typename Hash = std::hash<Key>> class FlatLRUCache {
+  private:
+    static constexpr uint32_t NIL = UINT32_MAX;
+
+    struct Node {
+        Key key{};
+        Value value{};
+        uint32_t prev = NIL;
+        uint32_t next = NIL;
+    };
+
+    // Index slot: node index plus the key's hash bits, to skip most key comparisons
+    struct Slot {
+        uint32_t node = NIL;
+        uint32_t tag = 0;
+    };
+
+    std::vector<Node> nodes_;
+    std::vector<Slot> slots_;
+    uint32_t head_;
+    uint32_t tail_;
+    uint32_t free_;
+    size_t size_;
+    size_t capacity_;
+    unsigned shift_;
+    Hash hash_;
+
+    uint64_t mix(const Key &key) const {
+        return static_cast<uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ull;
+    }
+
+    size_t home(uint64_t h) const {
+        return static_cast<size_t>(h >> shift_);
+    }
+
+    size_t mask() const {
+        return slots_.size() - 1;
+    }
+
+    // Slot holding key, or the empty slot that ends its probe sequence
+    size_t findSlot(const Key &key) const {
+        uint64_t h = mix(key);
+        uint32_t tag = static_cast<uint32_t>(h);
+        for (size_t i = home(h);; i = (i + 1) & mask()) {
+            const Slot &slot = slots_[i];
+            if (slot.node == NIL) return i;
+            if (slot.tag == tag && nodes_[slot.node].key == key) return i;
+        }
+    }
+
+    void eraseSlot(size_t i) {
+        // Backward-shift deletion keeps probe sequences unbroken without tombstones
+        for (size_t j = (i + 1) & mask(); slots_[j].node != NIL; j = (j + 1) & mask()) {
+            size_t h = home(mix(nodes_[slots_[j].node].key));
+            if (((j - h) & mask()) >= ((j - i) & mask())) {
+                slots_[i] = slots_[j];
+                i = j;
+            }
+        }
+        slots_[i].node = NIL;
+    }
+
+    void detach(uint32_t n) {
+        Node &node = nodes_[n];
+        if (node.prev != NIL)
+            nodes_[node.prev].next = node.next;
+        else
+            head_ = node.next;
+        if (node.next != NIL)
+            nodes_[node.next].prev = node.prev;
+        else
+            tail_ = node.prev;
+        node.prev = NIL;
+        node.next = NIL;
+    }
+
+    void push_front(uint32_t n) {
+        Node &node = nodes_[n];
+        node.prev = NIL;
+        node.next = head_;
+        if (head_ != NIL) nodes_[head_].prev = n;
+        head_ = n;
+        if (tail_ == NIL) tail_ = n;
+    }
+
+    // Runs in the initializer list, so an oversized capacity throws before nodes_ allocates
+    static size_t checkedCapacity(size_t capacity) {
+        if (capacity >= NIL) {
+            throw std::length_error("FlatLRUCache capacity must fit in 32 bits");
+        }
+        return capacity;
+    }
+
+  public:
+    explicit FlatLRUCache(size_t capacity)
+        : nodes_(checkedCapacity(capacity)), head_(NIL), tail_(NIL), free_(NIL), size_(0),
+          capacity_(capacity) {
+        // Index at most half full keeps linear probes short
+        size_t slots = 2;
+        unsigned bits = 1;
+        while (slots < capacity * 2) {
+            slots <<= 1;
+            bits++;
+        }
+        slots_.assign(slots, Slot{});
+        shift_ = 64 - bits;
+        clear();
+    }
+
+    std::optional<Value> get(const Key &key) {
+        size_t i = findSlot(key);
+        if (slots_[i].node == NIL) return std::nullopt;
+        uint32_t n = slots_[i].node;
+        detach(n);
+        push_front(n);
+        return nodes_[n].value;
+    }
+
+    void put(const Key &key, const Value &value) {
+        if (capacity_ == 0) return;
+        size_t i = findSlot(key);
+        if (slots_[i].node != NIL) {
+            uint32_t n = slots_[i].node;
+            detach(n);
+            push_front(n);
+            nodes_[n].value = value;
+            return;
+        }
+
+        uint32_t n;
+        if (free_ != NIL) {
+            n = free_;
+            free_ = nodes_[n].next;
+            size_++;
+        } else {
+            // Full: recycle the least recently used node
+            n = tail_;
+            eraseSlot(findSlot(nodes_[n].key));
+            detach(n);
+            i = findSlot(key);
+        }
+        nodes_[n].key = key;
+        nodes_[n].value = value;
+        slots_[i] = {n, static_cast<uint32_t>(mix(key))};
+        push_front(n);
+    }
+
+    bool contains(const Key &key) const {
+        return slots_[findSlot(key)].node != NIL;
+    }
+
+    size_t size() const {
+        return size_;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    // Returns every node to the free list; storage is kept
+    void clear() {
+        std::fill(slots_.begin(), slots_.end(), Slot{});
+        head_ = NIL;
+        tail_ = NIL;
+        free_ = NIL;
+        for (size_t n = nodes_.size(); n-- > 0;) {
+            nodes_[n].prev = NIL;
+            nodes_[n].next = free_;
+            free_ = static_cast<uint32_t>(n);
+        }
+        size_ = 0;
+    }
+};
+
+// How a ConcurrentLRUCache shard tracks recency. LRU relinks on every hit, so hits take the shard
+// lock exclusively; CLOCK (second chance) only sets a reference bit, so hits share the lock.
+enum class Recency { LRU, CLOCK };
+
+// Thread-safe cache split into independently locked shards chosen by key hash. Capacity is
+// divided between shards, the first capacity % shards taking one extra entry, so the cache
+// never holds more than capacity and eviction order is per shard, not global. CLOCK mode needs
+// default-constructible Key and Value.
+template <typename Key, typename Value, Recency Mode = Recency::LRU,
+          typename Hash = std::hash<Key>>
+class ConcurrentLRUCache {
+  private:
+    // Exact LRU under an exclusive lock
+    struct alignas(64) LruShard {
+        std::mutex mutex;
+        LRUCache<Key, Value, Hash> cache;
+
+        explicit LruShard(size_t capacity) : cache(capacity) {}
+
+        std::optional<Value> get(const Key &key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return cache.get(key);
+        }
+
+        template <typename Fn> bool visit(const Key &key, Fn &fn) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return cache.visit(key, fn);
+        }
+
+        void put(const Key &key, const Value &value) {
+            std::lock_guard<std::mutex> lock(mutex);
+            cache.put(key, value);
+        }
+
+        bool contains(const Key &key) {
+            std::lock_guard<std::mutex> lock(mutex);
+            return cache.contains(key);
+        }
+
+        size_t size() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return cache.size();
+        }
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            cache.clear();
+        }
+    };
+
+    // Fixed ring of slots swept by a clock hand; hits run under a shared lock
+    struct alignas(64) ClockShard {
+        struct Slot {
+            Key key{};
+            Value value{};
+            std::atomic<bool> referenced{false};
+        };
+
+        std::shared_mutex mutex;
+        std::unique_ptr<Slot[]> slots;
+        std::unordered_map<Key, size_t, Hash> index;
+        size_t capacity;
+        size_t used = 0;
+        size_t hand = 0;
+
+        explicit ClockShard(size_t capacity) : slots(new Slot[capacity]), capacity(capacity) {
+            index.reserve(capacity);
+        }
+
+        std::optional<Value> get(const Key &key) {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = index.find(key);
+            if (it == index.end()) return std::nullopt;
+            Slot &slot = slots[it->second];
+            // Skip the store when already set so hot keys don't bounce their cache line
+            if (!slot.referenced.load(std::memory_order_relaxed)) {
+                slot.referenced.store(true, std::memory_order_relaxed);
+            }
+            return slot.value;
+        }
+
+        template <typename Fn> bool visit(const Key &key, Fn &fn) {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            auto it = index.find(key);
+            if (it == index.end()) return false;
+            Slot &slot = slots[it->second];
+            if (!slot.referenced.load(std::memory_order_relaxed)) {
+                slot.referenced.store(true, std::memory_order_relaxed);
+            }
+            // Other readers may hold the same slot, so fn only gets const access
+            fn(static_cast<const Value &>(slot.value));
+            return true;
+        }
+
+        void put(const Key &key, const Value &value) {
+            if (capacity == 0) return;
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            auto it = index.find(key);
+            if (it != index.end()) {
+                Slot &slot = slots[it->second];
+                slot.value = value;
+                slot.referenced.store(true, std::memory_order_relaxed);
+                return;
+            }
+
+            size_t victim;
+            if (used < capacity) {
+                victim = used++;
+            } else {
+                // Give every referenced slot a second chance before evicting it
+                while (slots[hand].referenced.load(std::memory_order_relaxed)) {
+                    slots[hand].referenced.store(false, std::memory_order_relaxed);
+                    hand = (hand + 1) % capacity;
+                }
+                victim = hand;
+                hand = (hand + 1) % capacity;
+                index.erase(slots[victim].key);
+            }
+            Slot &slot = slots[victim];
+            slot.key = key;
+            slot.value = value;
+            slot.referenced.store(false, std::memory_order_relaxed);
+            index.emplace(key, victim);
+        }
+
+        bool contains(const Key &key) {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            return index.find(key) != index.end();
+        }
+
+        size_t size() {
+            std::shared_lock<std::shared_mutex> lock(mutex);
+            return index.size();
+        }
+
+        // Also resets the used slots, so evicted keys and values are released now rather than
+        // when their slot is next reused
+        void clear() {
+            std::unique_lock<std::shared_mutex> lock(mutex);
+            for (size_t i = 0; i < used; ++i) {
+                slots[i].key = Key{};
+                slots[i].value = Value{};
+                slots[i].referenced.store(false, std::memory_order_relaxed);
+            }
+            index.clear();
+            used = 0;
+            hand = 0;
+        }
+    };
+
+    using Shard = std::conditional_t<Mode == Recency::CLOCK, ClockShard, LruShard>;
+
+    std::vector<std::unique_ptr<Shard>> shards_;
+    size_t shardMask_;
+    size_t capacity_;
+    Hash hash_;
+
+    // Shard choice uses the high bits of a mixed hash so it is independent of the bucket
+    // choice inside each shard's table
+    Shard &shardFor(const Key &key) const {
+        uint64_t h = static_cast<uint64_t>(hash_(key)) * 0x9E3779B97F4A7C15ull;
+        return *shards_[static_cast<size_t>(h >> 32) & shardMask_];
+    }
+
+  public:
+    // numShards is rounded up to a power of two
+    explicit ConcurrentLRUCache(size_t capacity, size_t numShards = 16) : capacity_(capacity) {
+        if (numShards == 0) {
+            throw std::invalid_argument("ConcurrentLRUCache needs at least one shard");
+        }
+        size_t count = 1;
+        while (count < numShards) {
+            count <<= 1;
+        }
+        shardMask_ = count - 1;
+        for (size_t i = 0; i < count; ++i) {
+            shards_.push_back(std::make_unique<Shard>(capacity / count + (i < capacity % count)));
+        }
+    }
+
+    std::optional<Value> get(const Key &key) {
+        return shardFor(key).get(key);
+    }
+
+    // Call fn on a hit while holding the shard lock, without copying the value. In CLOCK mode
+    // fn receives a const reference since other readers may be visiting the same entry.
+    template <typename Fn> bool visit(const Key &key, Fn &&fn) {
+        return shardFor(key).visit(key, fn);
+    }
+
+    void put(const Key &key, const Value &value) {
+        shardFor(key).put(key, value);
+    }
+
+    bool contains(const Key &key) const {
+        return shardFor(key).contains(key);
+    }
+
+    // Sum over shards; only a snapshot while other threads write
+    size_t size() const {
+        size_t total = 0;
+        for (const auto &shard : shards_) {
+            total += shard->size();
+        }
+        return total;
+    }
+
+    size_t capacity() const {
+        return capacity_;
+    }
+
+    size_t shardCount() const {
+        return shards_.size();
+    }
+
+    void clear() {
+        for (auto &shard : shards_) {
+            shard->clear();
+        }
+    }
+
+    ConcurrentLRUCache(const ConcurrentLRUCache &) = delete;
+    ConcurrentLRUCache &operator=(const ConcurrentLRUCache &) = delete;
+};
+
+#endif
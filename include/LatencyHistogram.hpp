@@ -0,0 +1,139 @@
+#ifndef LATENCYHISTOGRAM_HPP
+#define LATENCYHISTOGRAM_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// HDR-style log-linear histogram of non-negative integer values (typically nanoseconds).
+// Every power-of-two range is split into 2^SUB_BITS equal buckets, so any recorded value is
+// reported within 1 / 2^SUB_BITS (about 3%) of its true value, from 1ns up to 2^64.
+class LatencyHistogram {
+  public:
+    static constexpr unsigned SUB_BITS = 5;
+    static constexpr size_t SUB_BUCKETS = size_t{1} << SUB_BITS;
+    static constexpr size_t BUCKETS = (64 - SUB_BITS + 1) * SUB_BUCKETS;
+
+    LatencyHistogram() : counts_(BUCKETS, 0) {}
+
+    void record(uint64_t value) {
+        counts_[bucketOf(value)]++;
+        total_++;
+        sum_ += value;
+        min_ = std::min(min_, value);
+        max_ = std::max(max_, value);
+    }
+
+    // Add every sample of another histogram to this one
+    void merge(const LatencyHistogram &other) {
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            counts_[i] += other.counts_[i];
+        }
+        total_ += other.total_;
+        sum_ += other.sum_;
+        min_ = std::min(min_, other.min_);
+        max_ = std::max(max_, other.max_);
+    }
+
+    void reset() {
+        std::fill(counts_.begin(), counts_.end(), 0);
+        total_ = 0;
+        sum_ = 0;
+        min_ = UINT64_MAX;
+        max_ = 0;
+    }
+
+    uint64_t count() const {
+        return total_;
+    }
+
+    uint64_t min() const {
+        return total_ ? min_ : 0;
+    }
+
+    uint64_t max() const {
+        return max_;
+    }
+
+    double mean() const {
+        return total_ ? static_cast<double>(sum_) / static_cast<double>(total_) : 0.0;
+    }
+
+    // Smallest recorded value v such that a fraction q of the samples are <= v, reported as the
+    // upper edge of its bucket and never above the true maximum
+    uint64_t percentile(double q) const {
+        if (total_ == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(q * static_cast<double>(total_));
+        rank = std::clamp<uint64_t>(rank, 1, total_);
+        uint64_t seen = 0;
+        for (size_t i = 0; i < BUCKETS; ++i) {
+            seen += counts_[i];
+            if (seen >= rank) return std::min(upperBound(i), max_);
+        }
+        return max_;
+    }
+
+  private:
+    friend class AtomicLatencyHistogram;
+
+    std::vector<uint64_t> counts_;
+    uint64_t total_ = 0;
+    uint64_t sum_ = 0;
+    uint64_t min_ = UINT64_MAX;
+    uint64_t max_ = 0;
+
+    static size_t bucketOf(uint64_t value) {
+        if (value < SUB_BUCKETS) return static_cast<size_t>(value);
+        unsigned shift = static_cast<unsigned>(std::bit_width(value)) - 1 - SUB_BITS;
+        return (shift + 1) * SUB_BUCKETS + static_cast<size_t>(value >> shift) - SUB_BUCKETS;
+    }
+
+    // Largest value that lands in bucket i
+    static uint64_t upperBound(size_t i) {
+        if (i < SUB_BUCKETS) return i;
+        size_t shift = i / SUB_BUCKETS - 1;
+        uint64_t base = (i % SUB_BUCKETS + SUB_BUCKETS) << shift;
+        return base + ((uint64_t{1} << shift) - 1);
+    }
+};
+
+// Same buckets, recordable from many threads at once with relaxed atomics. snapshot() is not
+// taken at a single instant, but every sample it sees is complete apart from the summary fields.
+class AtomicLatencyHistogram {
+  public:
+    AtomicLatencyHistogram() : counts_(LatencyHistogram::BUCKETS) {}
+
+    void record(uint64_t value) {
+        counts_[LatencyHistogram::bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+        sum_.fetch_add(value, std::memory_order_relaxed);
+        uint64_t min = min_.load(std::memory_order_relaxed);
+        while (value < min && !min_.compare_exchange_weak(min, value, std::memory_order_relaxed)) {
+        }
+        uint64_t max = max_.load(std::memory_order_relaxed);
+        while (value > max && !max_.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    LatencyHistogram snapshot() const {
+        LatencyHistogram h;
+        for (size_t i = 0; i < LatencyHistogram::BUCKETS; ++i) {
+            h.counts_[i] = counts_[i].load(std::memory_order_relaxed);
+            h.total_ += h.counts_[i];
+        }
+        h.sum_ = sum_.load(std::memory_order_relaxed);
+        h.min_ = min_.load(std::memory_order_relaxed);
+        h.max_ = max_.load(std::memory_order_relaxed);
+        return h;
+    }
+
+  private:
+    std::vector<std::atomic<uint64_t>> counts_;
+    std::atomic<uint64_t> sum_{0};
+    std::atomic<uint64_t> min_{UINT64_MAX};
+    std::atomic<uint64_t> max_{0};
+};
+
+#endif
@@ -0,0 +1,889 @@
+#ifndef MARKETDATAPROCESSOR_HPP
+#define MARKETDATAPROCESSOR_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <climits>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "ThreadSafeQueue.hpp"
+#include "TickRecord.hpp"
+
+// Compact handle for a registered symbol, valid for the processor that issued it
+using SymbolId = uint32_t;
+
+// Lets string_view names probe a symbol registry without building a std::string
+struct SymbolNameHash {
+    using is_transparent = void;
+
+    size_t operator()(std::string_view name) const {
+        return std::hash<std::string_view>{}(name);
+    }
+};
+
+// Log-bucketed quantile sketch in the style of DDSketch: a positive value lands in bucket
+// ceil(log_gamma(value)), so every reported quantile is within RELATIVE_ACCURACY of a value that
+// was added. Bucket counts sit in a Fenwick tree, so add, remove and quantile are all
+// O(log buckets). Unlike t-digest or KLL it supports removal, which a sliding window needs, and
+// two sketches merge by adding counts. The tree covers only the range of values seen: it starts
+// at MIN_BUCKETS around the first value and doubles, re-anchored, whenever a value falls
+// outside it, so a symbol trading in a 1% band costs a few hundred bytes. Growth stops at
+// MAX_BUCKETS (256 KB, extremes about 5e5x apart); values beyond that are clamped into the
+// end buckets.
+class QuantileSketch {
+  public:
+    static constexpr double RELATIVE_ACCURACY = 0.0001;
+    static constexpr size_t MIN_BUCKETS = 64;
+    static constexpr size_t MAX_BUCKETS = 65536;
+
+    void add(double value) {
+        if (total == 0) anchor(value);
+        update(bucketOf(value), 1);
+        total++;
+    }
+
+    // value must have been added before
+    void remove(double value) {
+        update(bucketOf(value), -1);
+        total--;
+    }
+
+    uint64_t count() const {
+        return total;
+    }
+
+    // Buckets currently allocated
+    size_t buckets() const {
+        return tree.empty() ? 0 : tree.size() - 1;
+    }
+
+    // Value at quantile q in [0, 1], or 0 when the sketch is empty
+    double quantile(double q) const {
+        if (total == 0) return 0.0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(q * static_cast<double>(total)));
+        rank = std::clamp<uint64_t>(rank, 1, total);
+        // Fenwick descent to the first bucket whose cumulative count reaches rank
+        size_t n = buckets();
+        size_t pos = 0;
+        for (size_t step = n; step; step >>= 1) {
+            if (pos + step <= n && tree[pos + step] < rank) {
+                pos += step;
+                rank -= tree[pos];
+            }
+        }
+        return valueOf(pos);
+    }
+
+    void merge(const QuantileSketch &other) {
+        if (other.total == 0) return;
+        if (total == 0) {
+            tree = other.tree;
+            offset = other.offset;
+            total = other.total;
+            return;
+        }
+        std::vector<uint32_t> counts = other.counts();
+        for (size_t i = 0; i < counts.size(); ++i) {
+            if (counts[i]) update(bucketAt(other.offset + static_cast<long>(i)), counts[i]);
+        }
+        total += other.total;
+    }
+
+    void clear() {
+        tree.clear();
+        total = 0;
+    }
+
+  private:
+    std::vector<uint32_t> tree; // 1-based Fenwick tree over bucket counts, power-of-two size
+    long offset = 0;            // Absolute log-index of bucket 0
+    uint64_t total = 0;
+
+    static double gamma() {
+        return (1 + RELATIVE_ACCURACY) / (1 - RELATIVE_ACCURACY);
+    }
+
+    static long absoluteIndex(double value) {
+        static const double logGamma = std::log(gamma());
+        if (value <= 0.0) return LONG_MIN / 2;
+        return static_cast<long>(std::ceil(std::log(value) / logGamma));
+    }
+
+    // Center MIN_BUCKETS buckets on value; only done while empty
+    void anchor(double value) {
+        tree.assign(MIN_BUCKETS + 1, 0);
+        offset = value > 0.0 ? absoluteIndex(value) - static_cast<long>(MIN_BUCKETS / 2) : 0;
+    }
+
+    // Bucket for an absolute log-index, growing the tree to cover it while under MAX_BUCKETS.
+    // Growth never moves the covered range off a bucket already in it, so every value added
+    // keeps mapping to the bucket it was counted in.
+    size_t bucketAt(long index) {
+        long n = static_cast<long>(buckets());
+        if ((index < offset || index >= offset + n) && buckets() < MAX_BUCKETS) grow(index);
+        n = static_cast<long>(buckets());
+        return static_cast<size_t>(std::clamp<long>(index - offset, 0, n - 1));
+    }
+
+    size_t bucketOf(double value) {
+        return bucketAt(absoluteIndex(value));
+    }
+
+    // Re-anchor over at least the current range plus index, with as much room again for drift
+    void grow(long index) {
+        long n = static_cast<long>(buckets());
+        long low = std::min(offset, index);
+        long span = std::max(offset + n, index + 1) - low;
+        size_t size = std::min(std::bit_ceil(static_cast<size_t>(span)) * 2, MAX_BUCKETS);
+        long newOffset;
+        if (span <= static_cast<long>(size)) {
+            newOffset = low - (static_cast<long>(size) - span) / 2;
+        } else {
+            // Too wide even at MAX_BUCKETS: keep the current range and reach toward index
+            newOffset = index < offset ? offset + n - static_cast<long>(size) : offset;
+        }
+        std::vector<uint32_t> old = counts();
+        tree.assign(size + 1, 0);
+        for (size_t i = 0; i < old.size(); ++i) {
+            tree[static_cast<size_t>(offset - newOffset) + i + 1] = old[i];
+        }
+        // Linear-time Fenwick build: each node passes its sum up to its parent
+        for (size_t i = 1; i <= size; ++i) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= size) tree[parent] += tree[i];
+        }
+        offset = newOffset;
+    }
+
+    // Midpoint (in relative terms) of bucket i's value range
+    double valueOf(size_t i) const {
+        double g = gamma();
+        return 2.0 * std::pow(g, static_cast<double>(offset + static_cast<long>(i))) / (g + 1.0);
+    }
+
+    void update(size_t bucket, long delta) {
+        for (size_t i = bucket + 1; i < tree.size(); i += i & (~i + 1)) {
+            tree[i] += static_cast<uint32_t>(delta);
+        }
+    }
+
+    // Per-bucket counts, undoing the Fenwick sums in linear time
+    std::vector<uint32_t> counts() const {
+        std::vector<uint32_t> out(tree.begin() + (tree.empty() ? 0 : 1), tree.end());
+        for (size_t i = out.size(); i >= 1; --i) {
+            size_t parent = i + (i & (~i + 1));
+            if (parent <= out.size()) out[parent - 1] -= out[i - 1];
+        }
+        return out;
+    }
+};
+
+// When a price counts as an anomaly
+struct AnomalyRule {
+    enum Mode { STDDEV, PERCENTILE };
+
+    Mode mode = STDDEV;
+    double stddevs = 3.0;      // STDDEV: price > mean + stddevs * standard deviation
+    double percentile = 0.999; // PERCENTILE: price > this quantile of the window's prices
+};
+
+class MarketDataProcessor {
+  private:
+    // A symbol's window as a growable ring of timestamp, price and volume columns, oldest tick
+    // first. Positions are monotonic counters masked into the power-of-two columns, so expiry
+    // just advances head. Statistics stream through at most two contiguous runs of prices.
+    // Two monotonic queues of positions track the window's minimum and maximum price.
+    class TickColumns {
+      public:
+        size_t size() const {
+            return static_cast<size_t>(tail - head);
+        }
+
+        bool empty() const {
+            return tail == head;
+        }
+
+        long long oldestTimestamp() const {
+            return timestamps[head & mask];
+        }
+
+        long long newestTimestamp() const {
+            return timestamps[(tail - 1) & mask];
+        }
+
+        double minPrice() const {
+            return prices[lows.front() & mask];
+        }
+
+        double maxPrice() const {
+            return prices[highs.front() & mask];
+        }
+
+        void push(long long timestamp, double price, int volume) {
+            if (size() == timestamps.size()) grow();
+            if (!empty() && timestamp < newestTimestamp()) ordered = false;
+            timestamps[tail & mask] = timestamp;
+            prices[tail & mask] = price;
+            volumes[tail & mask] = volume;
+            // Prices that can no longer be the extreme of any window leave the queues
+            while (!lows.empty() && prices[lows.back() & mask] >= price) {
+                lows.pop_back();
+            }
+            while (!highs.empty() && prices[highs.back() & mask] <= price) {
+                highs.pop_back();
+            }
+            lows.push_back(tail, size() + 1);
+            highs.push_back(tail, size() + 1);
+            tail++;
+        }
+
+        // Drop the oldest ticks up to (but excluding) the first one no older than cutoff, and
+        // return how many were dropped. onPrice sees the price of each dropped tick.
+        template <typename Fn> size_t expireBefore(long long cutoff, Fn &&onPrice) {
+            uint64_t end = head;
+            if (ordered) {
+                // Timestamps are sorted, so the boundary can be found by binary search
+                uint64_t lo = head;
+                uint64_t hi = tail;
+                while (lo < hi) {
+                    uint64_t mid = lo + (hi - lo) / 2;
+                    if (timestamps[mid & mask] < cutoff)
+                        lo = mid + 1;
+                    else
+                        hi = mid;
+                }
+                end = lo;
+            } else {
+                while (end != tail && timestamps[end & mask] < cutoff) {
+                    end++;
+                }
+            }
+            size_t dropped = static_cast<size_t>(end - head);
+            forEachRun(head, end, [&onPrice](const double *run, size_t n) {
+                for (size_t i = 0; i < n; ++i) {
+                    onPrice(run[i]);
+                }
+            });
+            head = end;
+            lows.dropBefore(head);
+            highs.dropBefore(head);
+            if (empty()) ordered = true;
+            return dropped;
+        }
+
+        // fn(const double *prices, size_t n) over the window's prices, oldest first
+        template <typename Fn> void forEachPriceRun(Fn &&fn) const {
+            forEachRun(head, tail, fn);
+        }
+
+      private:
+        // Ring of tick positions; never holds more positions than the window has ticks
+        class PositionQueue {
+          public:
+            bool empty() const {
+                return tail == head;
+            }
+
+            uint64_t front() const {
+                return slots[head & mask];
+            }
+
+            uint64_t back() const {
+                return slots[(tail - 1) & mask];
+            }
+
+            void pop_back() {
+                tail--;
+            }
+
+            // capacityNeeded bounds the queue length after the push
+            void push_back(uint64_t position, size_t capacityNeeded) {
+                if (capacityNeeded > slots.size()) grow(capacityNeeded);
+                slots[tail++ & mask] = position;
+            }
+
+            void dropBefore(uint64_t position) {
+                while (!empty() && front() < position) {
+                    head++;
+                }
+            }
+
+          private:
+            std::vector<uint64_t> slots;
+            uint64_t mask = 0;
+            uint64_t head = 0;
+            uint64_t tail = 0;
+
+            void grow(size_t needed) {
+                size_t capacity = std::max<size_t>(16, std::bit_ceil(needed));
+                std::vector<uint64_t> bigger(capacity);
+                for (uint64_t i = head; i != tail; ++i) {
+                    bigger[i & (capacity - 1)] = slots[i & mask];
+                }
+                slots.swap(bigger);
+                mask = capacity - 1;
+            }
+        };
+
+        std::vector<long long> timestamps;
+        std::vector<double> prices;
+        std::vector<int> volumes;
+        uint64_t mask = 0;
+        uint64_t head = 0;
+        uint64_t tail = 0;
+        bool ordered = true; // Whether timestamps are non-decreasing from head to tail
+        PositionQueue lows;  // Positions of increasing prices; front is the minimum
+        PositionQueue highs; // Positions of decreasing prices; front is the maximum
+
+        template <typename Fn> void forEachRun(uint64_t from, uint64_t to, Fn &&fn) const {
+            while (from != to) {
+                size_t start = static_cast<size_t>(from & mask);
+                size_t n = std::min(static_cast<size_t>(to - from), prices.size() - start);
+                fn(prices.data() + start, n);
+                from += n;
+            }
+        }
+
+        // Double the columns. Positions stay valid: each tick moves to its position masked by
+        // the new size.
+        void grow() {
+            size_t capacity = timestamps.empty() ? 16 : timestamps.size() * 2;
+            uint64_t newMask = capacity - 1;
+            std::vector<long long> newTimestamps(capacity);
+            std::vector<double> newPrices(capacity);
+            std::vector<int> newVolumes(capacity);
+            for (uint64_t i = head; i != tail; ++i) {
+                newTimestamps[i & newMask] = timestamps[i & mask];
+                newPrices[i & newMask] = prices[i & mask];
+                newVolumes[i & newMask] = volumes[i & mask];
+            }
+            timestamps.swap(newTimestamps);
+            prices.swap(newPrices);
+            volumes.swap(newVolumes);
+            mask = newMask;
+        }
+    };
+
+    // A symbol's window plus running sums of its prices, kept relative to a reference price
+    // (the first price since the window was last empty) so the variance does not lose precision
+    // to cancellation when prices are large and the spread is small
+    struct SymbolWindow {
+        TickColumns ticks;
+        QuantileSketch prices; // Only fed under a PERCENTILE rule
+        double reference = 0.0;
+        double sum = 0.0;        // Sum of (price - reference)
+        double sumSquares = 0.0; // Sum of (price - reference)^2
+
+        void add(double price) {
+            if (ticks.empty()) {
+                reference = price;
+                sum = 0.0;
+                sumSquares = 0.0;
+            }
+            double d = price - reference;
+            sum += d;
+            sumSquares += d * d;
+        }
+
+        void remove(double price) {
+            double d = price - reference;
+            sum -= d;
+            sumSquares -= d * d;
+        }
+
+        double mean() const {
+            return reference + sum / static_cast<double>(ticks.size());
+        }
+
+        // Population standard deviation
+        double stddev() const {
+            double n = static_cast<double>(ticks.size());
+            double m = sum / n;
+            return std::sqrt(std::max(0.0, sumSquares / n - m * m));
+        }
+    };
+
+    std::unordered_map<std::string, SymbolId, SymbolNameHash, std::equal_to<>> symbolIds;
+    std::unordered_map<uint64_t, SymbolId> codeIds; // TickRecord symbol codes seen so far
+    std::vector<std::string> symbolNames;
+    std::vector<SymbolWindow> windows; // Indexed by SymbolId
+    AnomalyRule rule;
+
+    static const long TIME_WINDOW_MS = 60000;
+    static const int MIN_PRICES_FOR_STDDEV = 20;
+
+    // Remove old ticks outside the time window
+    void cleanOldTicks(SymbolWindow &window, long long currentTime) {
+        bool sketched = tracksQuantiles();
+        window.ticks.expireBefore(currentTime - TIME_WINDOW_MS, [&window, sketched](double price) {
+            window.remove(price);
+            if (sketched) window.prices.remove(price);
+        });
+    }
+
+    bool tracksQuantiles() const {
+        return rule.mode == AnomalyRule::PERCENTILE;
+    }
+
+    // Get the most recent timestamp for a symbol
+    long long getLatestTimestamp(SymbolId id) const {
+        const auto &ticks = windows.at(id).ticks;
+        return ticks.empty() ? 0 : ticks.newestTimestamp();
+    }
+
+    // Window of a known symbol name, or nullptr
+    const SymbolWindow *findWindow(std::string_view symbol) const {
+        auto it = symbolIds.find(symbol);
+        return it == symbolIds.end() ? nullptr : &windows[it->second];
+    }
+
+    double anomalyThreshold(const SymbolWindow &window) const {
+        if (static_cast<int>(window.ticks.size()) < MIN_PRICES_FOR_STDDEV) {
+            return std::numeric_limits<double>::infinity();
+        }
+        if (rule.mode == AnomalyRule::PERCENTILE) return window.prices.quantile(rule.percentile);
+        return window.mean() + rule.stddevs * window.stddev();
+    }
+
+    static size_t flagAnomalies(double threshold, std::span<const double> prices,
+                                std::span<bool> flags) {
+        if (flags.size() != prices.size()) {
+            throw std::invalid_argument("Flags must have the same length as prices");
+        }
+        size_t count = 0;
+        for (size_t i = 0; i < prices.size(); ++i) {
+            flags[i] = prices[i] > threshold;
+            count += flags[i];
+        }
+        return count;
+    }
+
+  public:
+    explicit MarketDataProcessor(const AnomalyRule &rule = AnomalyRule()) : rule(rule) {}
+
+    // Id for a symbol name, registering it on first use
+    SymbolId registerSymbol(std::string_view symbol) {
+        auto it = symbolIds.find(symbol);
+        if (it != symbolIds.end()) return it->second;
+        SymbolId id = static_cast<SymbolId>(windows.size());
+        symbolIds.emplace(std::string(symbol), id);
+        symbolNames.emplace_back(symbol);
+        windows.emplace_back();
+        return id;
+    }
+
+    std::optional<SymbolId> findSymbol(std::string_view symbol) const {
+        auto it = symbolIds.find(symbol);
+        if (it == symbolIds.end()) return std::nullopt;
+        return it->second;
+    }
+
+    const std::string &getSymbolName(SymbolId id) const {
+        return symbolNames.at(id);
+    }
+
+    // Process a tick
+    void processTick(SymbolId id, long long timestamp, double price, int volume) {
+        SymbolWindow &window = windows.at(id);
+        window.add(price);
+        window.ticks.push(timestamp, price, volume);
+        if (tracksQuantiles()) window.prices.add(price);
+        cleanOldTicks(window, timestamp);
+    }
+
+    // Id for a record's symbol code, registering its name on first sight
+    SymbolId registerSymbol(const TickRecord &tick) {
+        auto it = codeIds.find(tick.symbol);
+        if (it != codeIds.end()) return it->second;
+        SymbolId id = registerSymbol(tick.symbolName());
+        codeIds.emplace(tick.symbol, id);
+        return id;
+    }
+
+    // Timestamps are cut to the window's milliseconds
+    void processTick(const TickRecord &tick) {
+        processTick(registerSymbol(tick), tick.timestampMs(), tick.price(), tick.volume);
+    }
+
+    // Replay a run of records, e.g. a span of a TickFileReader. Runs of one symbol skip the
+    // code lookup.
+    void processTicks(std::span<const TickRecord> ticks) {
+        uint64_t code = 0;
+        SymbolId id = 0;
+        for (const TickRecord &tick : ticks) {
+            if (tick.symbol != code || code == 0) {
+                code = tick.symbol;
+                id = registerSymbol(tick);
+            }
+            processTick(id, tick.timestampMs(), tick.price(), tick.volume);
+        }
+    }
+
+    // Moving average over 1 minute (60000ms)
+    double getMovingAverage(SymbolId id) const {
+        const SymbolWindow &window = windows.at(id);
+        return window.ticks.empty() ? 0. : window.mean();
+    }
+
+    double getMovingAverage(std::string_view symbol) const {
+        auto id = findSymbol(symbol);
+        return id ? getMovingAverage(*id) : 0.;
+    }
+
+    // Lowest and highest price in the window (0 when it is empty)
+    double getMinPrice(SymbolId id) const {
+        const SymbolWindow &window = windows.at(id);
+        return window.ticks.empty() ? 0. : window.ticks.minPrice();
+    }
+
+    double getMaxPrice(SymbolId id) const {
+        const SymbolWindow &window = windows.at(id);
+        return window.ticks.empty() ? 0. : window.ticks.maxPrice();
+    }
+
+    // Price at quantile q of the window, within QuantileSketch::RELATIVE_ACCURACY. Only
+    // available under a PERCENTILE rule, which keeps the sketches.
+    double getPercentile(SymbolId id, double q) const {
+        if (!tracksQuantiles()) {
+            throw std::logic_error("Quantiles are only tracked under a PERCENTILE anomaly rule");
+        }
+        return windows.at(id).prices.quantile(q);
+    }
+
+    // Price above which a tick is an anomaly under the rule, or +infinity while the window is
+    // too small to judge
+    double getAnomalyThreshold(SymbolId id) const {
+        return anomalyThreshold(windows.at(id));
+    }
+
+    double getAnomalyThreshold(std::string_view symbol) const {
+        auto id = findSymbol(symbol);
+        return id ? getAnomalyThreshold(*id) : std::numeric_limits<double>::infinity();
+    }
+
+    // Detect anomaly (by default price > mean + 3*standard_deviation)
+    bool isAnomaly(SymbolId id, double price) const {
+        return price > getAnomalyThreshold(id);
+    }
+
+    bool isAnomaly(std::string_view symbol, double price) const {
+        return price > getAnomalyThreshold(symbol);
+    }
+
+    // Check many prices against one threshold; flags[i] is set for prices[i]. Returns the
+    // number of anomalies.
+    size_t isAnomaly(SymbolId id, std::span<const double> prices, std::span<bool> flags) const {
+        return flagAnomalies(getAnomalyThreshold(id), prices, flags);
+    }
+
+    size_t isAnomaly(std::string_view symbol, std::span<const double> prices,
+                     std::span<bool> flags) const {
+        return flagAnomalies(getAnomalyThreshold(symbol), prices, flags);
+    }
+
+    // Stats for debugging
+    void printStats(std::string_view symbol) const {
+        const SymbolWindow *found = findWindow(symbol);
+        if (!found) {
+            std::cout << "No data for symbol: " << symbol << std::endl;
+            return;
+        }
+
+        const auto &window = *found;
+        const auto &ticks = window.ticks;
+        std::cout << "=== Stats for " << symbol << " ===" << std::endl;
+        std::cout << "Number of ticks in window: " << ticks.size() << std::endl;
+
+        if (!ticks.empty()) {
+            std::cout << "Time range: " << ticks.newestTimestamp() << " to "
+                      << ticks.oldestTimestamp() << " ms" << std::endl;
+            std::cout << "Moving average: " << window.mean() << std::endl;
+
+            if (ticks.size() >= MIN_PRICES_FOR_STDDEV) {
+                double stddev = window.stddev();
+                std::cout << "Standard deviation: " << stddev << std::endl;
+                if (rule.mode == AnomalyRule::PERCENTILE) {
+                    std::cout << "Anomaly threshold (p" << rule.percentile * 100
+                              << "): " << anomalyThreshold(window) << std::endl;
+                } else {
+                    std::cout << "Anomaly threshold (mean + " << rule.stddevs
+                              << "σ): " << anomalyThreshold(window) << std::endl;
+                }
+            } else {
+                std::cout << "Insufficient data for anomaly detection (need "
+                          << MIN_PRICES_FOR_STDDEV << " prices)" << std::endl;
+            }
+
+            // Show price range
+            std::cout << "Price range: [" << ticks.minPrice() << ", " << ticks.maxPrice() << "]"
+                      << std::endl;
+        }
+        std::cout << std::endl;
+    }
+
+    void printStats(SymbolId id) const {
+        printStats(getSymbolName(id));
+    }
+
+    // Get number of ticks for a symbol (for testing)
+    size_t getTickCount(SymbolId id) const {
+        return windows.at(id).ticks.size();
+    }
+
+    size_t getTickCount(std::string_view symbol) const {
+        const SymbolWindow *window = findWindow(symbol);
+        return window ? window->ticks.size() : 0;
+    }
+};
+
+// Statistics of one symbol's window as published by ShardedMarketDataProcessor
+struct SymbolSnapshot {
+    size_t tickCount = 0;
+    double movingAverage = 0.0;
+    double anomalyThreshold = std::numeric_limits<double>::infinity();
+    double minPrice = 0.0;
+    double maxPrice = 0.0;
+};
+
+// MarketDataProcessor spread over worker threads, with symbols partitioned by name hash. Each
+// worker owns a private MarketDataProcessor for its symbols and consumes its own queue. After
+// every tick it publishes that symbol's statistics through a seqlock, so readers on any thread
+// never take a lock and never see a torn snapshot. Symbols are registered before start(), which
+// keeps routing and the snapshot table read-only while running.
+class ShardedMarketDataProcessor {
+  private:
+    struct QueuedTick {
+        SymbolId local; // Id within the shard's processor
+        long long timestamp;
+        double price;
+        int volume;
+    };
+
+    // Seqlock around a SymbolSnapshot; the fields are atomics so that a read overlapping a
+    // write is not a data race, and the sequence tells the reader to retry
+    struct alignas(64) PublishedSnapshot {
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<size_t> tickCount{0};
+        std::atomic<double> movingAverage{0.0};
+        std::atomic<double> anomalyThreshold{std::numeric_limits<double>::infinity()};
+        std::atomic<double> minPrice{0.0};
+        std::atomic<double> maxPrice{0.0};
+
+        // Single writer: the worker that owns the symbol
+        void publish(const SymbolSnapshot &snapshot) {
+            uint64_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            tickCount.store(snapshot.tickCount, std::memory_order_relaxed);
+            movingAverage.store(snapshot.movingAverage, std::memory_order_relaxed);
+            anomalyThreshold.store(snapshot.anomalyThreshold, std::memory_order_relaxed);
+            minPrice.store(snapshot.minPrice, std::memory_order_relaxed);
+            maxPrice.store(snapshot.maxPrice, std::memory_order_relaxed);
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        SymbolSnapshot read() const {
+            SymbolSnapshot snapshot;
+            while (true) {
+                uint64_t before = sequence.load(std::memory_order_acquire);
+                if (before & 1) continue;
+                snapshot.tickCount = tickCount.load(std::memory_order_relaxed);
+                snapshot.movingAverage = movingAverage.load(std::memory_order_relaxed);
+                snapshot.anomalyThreshold = anomalyThreshold.load(std::memory_order_relaxed);
+                snapshot.minPrice = minPrice.load(std::memory_order_relaxed);
+                snapshot.maxPrice = maxPrice.load(std::memory_order_relaxed);
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == before) return snapshot;
+            }
+        }
+    };
+
+    struct Route {
+        size_t shard;
+        SymbolId local;
+    };
+
+    // Everything a worker touches, kept on its own cache lines
+    struct alignas(64) Shard {
+        Shard(size_t queueCapacity, const AnomalyRule &rule)
+            : inbox(queueCapacity), processor(rule) {}
+
+        ThreadSafeQueue<QueuedTick> inbox;
+        MarketDataProcessor processor;
+        std::vector<SymbolId> globalIds; // Indexed by local id
+        std::thread worker;
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::vector<Route> routes; // Indexed by SymbolId
+    std::unordered_map<std::string, SymbolId, SymbolNameHash, std::equal_to<>> symbolIds;
+    std::unordered_map<uint64_t, SymbolId> codeIds; // Names that fit a TickRecord code
+    std::vector<std::string> symbolNames;
+    std::deque<PublishedSnapshot> snapshots; // Indexed by SymbolId; deque keeps them in place
+    bool running;
+    bool stopped;
+
+    void workerLoop(Shard &shard) {
+        try {
+            while (true) {
+                QueuedTick tick = shard.inbox.pop();
+                MarketDataProcessor &processor = shard.processor;
+                processor.processTick(tick.local, tick.timestamp, tick.price, tick.volume);
+
+                SymbolSnapshot snapshot;
+                snapshot.tickCount = processor.getTickCount(tick.local);
+                snapshot.movingAverage = processor.getMovingAverage(tick.local);
+                snapshot.anomalyThreshold = processor.getAnomalyThreshold(tick.local);
+                snapshot.minPrice = processor.getMinPrice(tick.local);
+                snapshot.maxPrice = processor.getMaxPrice(tick.local);
+                snapshots[shard.globalIds[tick.local]].publish(snapshot);
+            }
+        } catch (const std::runtime_error &) {
+            // pop() throws once the inbox is shut down and drained
+        }
+    }
+
+  public:
+    explicit ShardedMarketDataProcessor(size_t numShards, const AnomalyRule &rule = AnomalyRule(),
+                                        size_t queueCapacity = 65536)
+        : running(false), stopped(false) {
+        if (numShards == 0) {
+            throw std::invalid_argument("Processor needs at least one shard");
+        }
+        for (size_t i = 0; i < numShards; ++i) {
+            shards.push_back(std::make_unique<Shard>(queueCapacity, rule));
+        }
+    }
+
+    ~ShardedMarketDataProcessor() {
+        stop();
+    }
+
+    ShardedMarketDataProcessor(const ShardedMarketDataProcessor &) = delete;
+    ShardedMarketDataProcessor &operator=(const ShardedMarketDataProcessor &) = delete;
+
+    // Id for a symbol name, registering it on first use; only allowed before start()
+    SymbolId registerSymbol(std::string_view symbol) {
+        auto it = symbolIds.find(symbol);
+        if (it != symbolIds.end()) return it->second;
+        if (running) {
+            throw std::logic_error("Symbols must be registered before the processor starts");
+        }
+        SymbolId id = static_cast<SymbolId>(routes.size());
+        size_t shard = std::hash<std::string_view>{}(symbol) % shards.size();
+        routes.push_back({shard, shards[shard]->processor.registerSymbol(symbol)});
+        shards[shard]->globalIds.push_back(id);
+        symbolIds.emplace(std::string(symbol), id);
+        if (!symbol.empty() && symbol.size() <= 8) {
+            codeIds.emplace(TickRecord::encodeSymbol(symbol), id);
+        }
+        symbolNames.emplace_back(symbol);
+        snapshots.emplace_back();
+        return id;
+    }
+
+    std::optional<SymbolId> findSymbol(std::string_view symbol) const {
+        auto it = symbolIds.find(symbol);
+        if (it == symbolIds.end()) return std::nullopt;
+        return it->second;
+    }
+
+    const std::string &getSymbolName(SymbolId id) const {
+        return symbolNames.at(id);
+    }
+
+    size_t shardOf(SymbolId id) const {
+        return routes.at(id).shard;
+    }
+
+    size_t shardCount() const {
+        return shards.size();
+    }
+
+    // Launch one worker per shard. A processor runs once: stop() shuts its queues down, so a
+    // restart throws.
+    void start() {
+        if (running) return;
+        if (stopped) {
+            throw std::logic_error("A stopped processor cannot be restarted");
+        }
+        running = true;
+        for (auto &shard : shards) {
+            shard->worker = std::thread(&ShardedMarketDataProcessor::workerLoop, this,
+                                        std::ref(*shard));
+        }
+    }
+
+    // Drain every queue and join the workers. The queues are shut down, so stop() is final.
+    void stop() {
+        if (!running) return;
+        for (auto &shard : shards) {
+            shard->inbox.shutdown();
+        }
+        for (auto &shard : shards) {
+            if (shard->worker.joinable()) shard->worker.join();
+        }
+        running = false;
+        stopped = true;
+    }
+
+    // Queue a tick for its symbol's worker; blocks while that worker's queue is full. Ticks of
+    // one symbol must come from one thread to keep their order.
+    void processTick(SymbolId id, long long timestamp, double price, int volume) {
+        const Route &route = routes.at(id);
+        shards[route.shard]->inbox.push({route.local, timestamp, price, volume});
+    }
+
+    // The symbol must already be registered
+    void processTick(const TickRecord &tick) {
+        auto it = codeIds.find(tick.symbol);
+        if (it == codeIds.end()) {
+            throw std::out_of_range("Unknown symbol: " + std::string(tick.symbolName()));
+        }
+        processTick(it->second, tick.timestampMs(), tick.price(), tick.volume);
+    }
+
+    // Latest published statistics; safe from any thread
+    SymbolSnapshot getSnapshot(SymbolId id) const {
+        return snapshots.at(id).read();
+    }
+
+    double getMovingAverage(SymbolId id) const {
+        return getSnapshot(id).movingAverage;
+    }
+
+    double getMovingAverage(std::string_view symbol) const {
+        auto id = findSymbol(symbol);
+        return id ? getMovingAverage(*id) : 0.;
+    }
+
+    bool isAnomaly(SymbolId id, double price) const {
+        return price > getSnapshot(id).anomalyThreshold;
+    }
+
+    bool isAnomaly(std::string_view symbol, double price) const {
+        auto id = findSymbol(symbol);
+        return id ? isAnomaly(*id, price) : false;
+    }
+
+    size_t getTickCount(SymbolId id) const {
+        return getSnapshot(id).tickCount;
+    }
+};
+
+#endif
@@ -0,0 +1,274 @@
+#ifndef MATCHINGENGINE_HPP
+#define MATCHINGENGINE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "OrderBook.hpp"
+#include "ThreadSafeQueue.hpp"
+
+// One instruction for the book of a single symbol
+struct EngineCommand {
+    enum Type { ADD, CANCEL, MODIFY };
+
+    Type type;
+    uint32_t symbol;
+    OrderBookTypes::Side side;
+    double price;
+    int quantity;
+    int orderID;
+};
+
+// Multi-symbol engine: every symbol gets its own book, and symbols are spread round-robin over a
+// fixed set of shards. Each shard is one worker thread with a private inbound queue and private
+// books, so shards share no locks and a book is only ever touched by its own worker.
+//
+// EventSink is the book-level sink type; makeSink builds one per book, given the shard and the
+// symbol, so a shard's books can share a per-shard ring (see RingSink) without cross-thread
+// traffic.
+template <typename EventSink = NullSink> class MatchingEngine {
+  public:
+    using SymbolId = uint32_t;
+    using Book = BasicOrderBook<EventSink>;
+    using SinkFactory = std::function<EventSink(size_t shard, SymbolId symbol)>;
+
+    // tickSize == 0 selects the std::map book, otherwise a price ladder over [minPrice, maxPrice]
+    struct BookConfig {
+        double tickSize = 0.0;
+        double minPrice = 0.0;
+        double maxPrice = 0.0;
+        size_t reserveOrders = 0;
+    };
+
+    // cpus[i], when given, is the core shard i's worker is pinned to
+    explicit MatchingEngine(size_t numShards, SinkFactory makeSink = nullptr,
+                            std::vector<int> cpus = {}, size_t queueCapacity = 65536)
+        : makeSink_(std::move(makeSink)), running_(false), stopped_(false) {
+        if (numShards == 0) {
+            throw std::invalid_argument("Engine needs at least one shard");
+        }
+        if constexpr (!std::is_default_constructible_v<EventSink>) {
+            if (!makeSink_) throw std::invalid_argument("This sink type needs a sink factory");
+        }
+        for (size_t i = 0; i < numShards; ++i) {
+            auto shard = std::make_unique<Shard>(queueCapacity);
+            shard->cpu = i < cpus.size() ? cpus[i] : -1;
+            shards_.push_back(std::move(shard));
+        }
+    }
+
+    ~MatchingEngine() {
+        stop();
+    }
+
+    MatchingEngine(const MatchingEngine &) = delete;
+    MatchingEngine &operator=(const MatchingEngine &) = delete;
+
+    // Register a symbol; only allowed before start(). The config is checked here, so the
+    // workers that build the books later cannot fail on it.
+    SymbolId addSymbol(const std::string &name, const BookConfig &config = BookConfig()) {
+        if (running_) {
+            throw std::logic_error("Symbols must be added before the engine starts");
+        }
+        if (symbolIds_.count(name)) {
+            throw std::invalid_argument("Symbol already registered: " + name);
+        }
+        if (config.tickSize < 0.0) {
+            throw std::invalid_argument("Tick size must be positive");
+        }
+        if (config.tickSize > 0.0) {
+            Book::ladderLevels(config.tickSize, config.minPrice, config.maxPrice);
+        }
+        SymbolId id = static_cast<SymbolId>(routes_.size());
+        size_t shard = id % shards_.size();
+        routes_.push_back({shard, shards_[shard]->configs.size()});
+        shards_[shard]->configs.push_back({id, config});
+        symbolIds_.emplace(name, id);
+        names_.push_back(name);
+        return id;
+    }
+
+    SymbolId symbolId(const std::string &name) const {
+        auto it = symbolIds_.find(name);
+        if (it == symbolIds_.end()) {
+            throw std::out_of_range("Unknown symbol: " + name);
+        }
+        return it->second;
+    }
+
+    const std::string &symbolName(SymbolId id) const {
+        return names_.at(id);
+    }
+
+    size_t shardOf(SymbolId id) const {
+        return routes_.at(id).shard;
+    }
+
+    size_t shardCount() const {
+        return shards_.size();
+    }
+
+    // Launch the workers; each builds its own books so their memory is first touched locally.
+    // An engine runs once: its inboxes are shut down by stop(), so a restart throws.
+    void start() {
+        if (running_) return;
+        if (stopped_) {
+            throw std::logic_error("A stopped engine cannot be restarted");
+        }
+        running_ = true;
+        for (size_t i = 0; i < shards_.size(); ++i) {
+            shards_[i]->worker = std::thread(&MatchingEngine::workerLoop, this, i);
+        }
+    }
+
+    // Drain every inbox and join the workers. The queues are shut down, so stop() is final.
+    void stop() {
+        if (!running_) return;
+        for (auto &shard : shards_) {
+            shard->inbox.shutdown();
+        }
+        for (auto &shard : shards_) {
+            if (shard->worker.joinable()) shard->worker.join();
+        }
+        running_ = false;
+        stopped_ = true;
+    }
+
+    // Route a command to its symbol's shard; blocks while that shard's inbox is full
+    void submit(const EngineCommand &command) {
+        shards_[routes_.at(command.symbol).shard]->inbox.push(command);
+    }
+
+    void addOrder(SymbolId symbol, OrderBookTypes::Side side, double price, int quantity,
+                  int orderID) {
+        submit({EngineCommand::ADD, symbol, side, price, quantity, orderID});
+    }
+
+    void cancelOrder(SymbolId symbol, int orderID) {
+        submit({EngineCommand::CANCEL, symbol, OrderBookTypes::BUY, 0.0, 0, orderID});
+    }
+
+    void modifyOrder(SymbolId symbol, int orderID, int newQuantity) {
+        submit({EngineCommand::MODIFY, symbol, OrderBookTypes::BUY, 0.0, newQuantity, orderID});
+    }
+
+    // A symbol's book, for inspection once the engine has stopped
+    const Book &book(SymbolId symbol) const {
+        if (running_) {
+            throw std::logic_error("Books are owned by the workers while the engine runs");
+        }
+        const Route &route = routes_.at(symbol);
+        const Shard &shard = *shards_[route.shard];
+        if (route.slot >= shard.books.size()) {
+            throw std::logic_error("Engine has not been started");
+        }
+        return *shard.books[route.slot];
+    }
+
+  private:
+    struct Route {
+        size_t shard;
+        size_t slot;
+    };
+
+    struct SymbolConfig {
+        SymbolId id;
+        BookConfig config;
+    };
+
+    // Everything a worker touches, kept on its own cache lines
+    struct alignas(64) Shard {
+        explicit Shard(size_t queueCapacity) : inbox(queueCapacity) {}
+
+        ThreadSafeQueue<EngineCommand> inbox;
+        std::vector<SymbolConfig> configs;
+        std::vector<std::unique_ptr<Book>> books;
+        std::thread worker;
+        int cpu = -1;
+    };
+
+    SinkFactory makeSink_;
+    std::vector<std::unique_ptr<Shard>> shards_;
+    std::vector<Route> routes_; // Indexed by SymbolId, read-only once running
+    std::unordered_map<std::string, SymbolId> symbolIds_;
+    std::vector<std::string> names_;
+    bool running_;
+    bool stopped_;
+
+    static void pinToCpu(int cpu) {
+#ifdef __linux__
+        if (cpu < 0) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cpu, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void) cpu;
+#endif
+    }
+
+    // Without a factory every book gets a default-constructed sink; the constructor has made
+    // sure there is one when the sink type needs it
+    EventSink createSink(size_t shard, SymbolId id) const {
+        if constexpr (std::is_default_constructible_v<EventSink>) {
+            if (!makeSink_) return EventSink();
+        }
+        return makeSink_(shard, id);
+    }
+
+    void workerLoop(size_t index) {
+        Shard &shard = *shards_[index];
+        pinToCpu(shard.cpu);
+
+        shard.books.reserve(shard.configs.size());
+        for (const auto &entry : shard.configs) {
+            EventSink sink = createSink(index, entry.id);
+            const BookConfig &config = entry.config;
+            std::unique_ptr<Book> book =
+                config.tickSize > 0.0
+                    ? std::make_unique<Book>(config.tickSize, config.minPrice, config.maxPrice,
+                                             std::move(sink))
+                    : std::make_unique<Book>(std::move(sink));
+            if (config.reserveOrders) book->reserve(config.reserveOrders);
+            shard.books.push_back(std::move(book));
+        }
+
+        try {
+            while (true) {
+                EngineCommand command = shard.inbox.pop();
+                apply(*shard.books[routes_[command.symbol].slot], command);
+            }
+        } catch (const std::runtime_error &) {
+            // pop() throws once the inbox is shut down and drained
+        }
+    }
+
+    static void apply(Book &book, const EngineCommand &command) {
+        switch (command.type) {
+        case EngineCommand::ADD:
+            book.addOrder(command.side, command.price, command.quantity, command.orderID);
+            break;
+        case EngineCommand::CANCEL:
+            book.cancelOrder(command.orderID);
+            break;
+        case EngineCommand::MODIFY:
+            book.modifyOrder(command.orderID, command.quantity);
+            break;
+        }
+    }
+};
+
+#endif
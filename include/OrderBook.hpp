@@ -0,0 +1,914 @@
+#ifndef ORDERBOOK_HPP
+#define ORDERBOOK_HPP
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cfloat>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// Side and execution reports shared by every OrderBook instantiation
+struct OrderBookTypes {
+    enum Side { BUY, SELL };
+
+    // An incoming order filled against a resting one at the resting order's price
+    struct Trade {
+        int aggressorID;
+        int restingID;
+        Side aggressorSide;
+        double price;
+        int quantity;
+    };
+
+    enum AckStatus { RESTING, FULLY_FILLED, MODIFIED };
+
+    // An add or modify was accepted; quantity is what now rests on the book
+    struct Ack {
+        int orderID;
+        Side side;
+        double price;
+        int quantity;
+        AckStatus status;
+    };
+
+    // A resting order left the book at the owner's request
+    struct Cancel {
+        int orderID;
+        Side side;
+        double price;
+        int quantity;
+    };
+
+    enum RequestType { ADD, CANCEL, MODIFY };
+    enum RejectReason { INVALID_QUANTITY, INVALID_PRICE, UNKNOWN_ORDER };
+
+    struct Reject {
+        int orderID;
+        RequestType request;
+        RejectReason reason;
+        double price;
+    };
+
+    // L2: aggregate state of one price level
+    struct DepthLevel {
+        double price;
+        long long quantity;
+        int orderCount;
+    };
+
+    // L3: one resting order, in queue order
+    struct OrderInfo {
+        int orderID;
+        int quantity;
+        long long timestamp;
+    };
+
+    // New state of a level after a change; quantity 0 means the level was removed
+    struct LevelUpdate {
+        uint64_t sequence;
+        Side side;
+        double price;
+        long long quantity;
+        int orderCount;
+    };
+};
+
+// Default sink: the human-readable log the book has always printed
+struct PrintingSink : OrderBookTypes {
+    void onTrade(const Trade &t) {
+        std::cout << "Trade executed: " << (t.aggressorSide == BUY ? "BUY" : "SELL")
+                  << " ID=" << t.aggressorID << " with "
+                  << (t.aggressorSide == BUY ? "SELL" : "BUY") << " ID=" << t.restingID
+                  << " at Price=" << t.price << " Qty=" << t.quantity << std::endl;
+    }
+
+    void onAck(const Ack &a) {
+        const char *side = a.side == BUY ? "BUY" : "SELL";
+        switch (a.status) {
+        case RESTING:
+            std::cout << "Added " << side << " order: ID=" << a.orderID << ", Price=" << a.price
+                      << ", Qty=" << a.quantity << std::endl;
+            break;
+        case FULLY_FILLED:
+            std::cout << side << " order ID=" << a.orderID << " fully executed upon entry."
+                      << std::endl;
+            break;
+        case MODIFIED:
+            std::cout << "Modified order ID=" << a.orderID << ", Qty=" << a.quantity << std::endl;
+            break;
+        }
+    }
+
+    void onCancel(const Cancel &c) {
+        std::cout << "Cancelled order ID=" << c.orderID << std::endl;
+    }
+
+    void onReject(const Reject &r) {
+        switch (r.reason) {
+        case INVALID_QUANTITY:
+            std::cerr << "Quantity must be positive." << std::endl;
+            break;
+        case INVALID_PRICE:
+            std::cerr << "Price " << r.price << " is outside the ladder band or off the tick grid."
+                      << std::endl;
+            break;
+        case UNKNOWN_ORDER:
+            std::cerr << "Order ID=" << r.orderID << " not found for "
+                      << (r.request == CANCEL ? "cancellation." : "modification.") << std::endl;
+            break;
+        }
+    }
+};
+
+// Discards every event, for embedding the book where nobody consumes reports
+struct NullSink : OrderBookTypes {
+    void onTrade(const Trade &) {}
+    void onAck(const Ack &) {}
+    void onCancel(const Cancel &) {}
+    void onReject(const Reject &) {}
+};
+
+// Tagged union of the reports, small enough to copy through a ring
+struct ExecutionEvent : OrderBookTypes {
+    enum Type { TRADE, ACK, CANCEL, REJECT };
+
+    Type type;
+    uint32_t symbol; // Set by the publishing sink when several books share a ring
+    union {
+        Trade trade;
+        Ack ack;
+        Cancel cancel;
+        Reject reject;
+    };
+};
+
+// Preallocated single-producer/single-consumer ring of events. The book's thread publishes,
+// another thread drains in batches and does the formatting or I/O.
+class EventRing {
+  public:
+    // Capacity is rounded up to a power of two
+    explicit EventRing(size_t capacity = 65536)
+        : mask_(std::bit_ceil(capacity) - 1), events_(new ExecutionEvent[mask_ + 1]) {}
+
+    // Spins while the ring is full; execution reports are never dropped
+    void publish(const ExecutionEvent &event) {
+        size_t head = head_.load(std::memory_order_relaxed);
+        while (head - tail_.load(std::memory_order_acquire) > mask_) {
+            std::this_thread::yield();
+        }
+        events_[head & mask_] = event;
+        head_.store(head + 1, std::memory_order_release);
+    }
+
+    // Hand up to maxEvents pending events to fn; returns how many were consumed
+    template <typename Fn> size_t drain(Fn &&fn, size_t maxEvents = SIZE_MAX) {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        size_t available = head_.load(std::memory_order_acquire) - tail;
+        size_t count = std::min(available, maxEvents);
+        for (size_t i = 0; i < count; ++i) {
+            fn(events_[(tail + i) & mask_]);
+        }
+        tail_.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+  private:
+    size_t mask_;
+    std::unique_ptr<ExecutionEvent[]> events_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+// Forwards every report into an EventRing owned by the caller, tagged with a symbol ID
+class RingSink : public OrderBookTypes {
+  public:
+    explicit RingSink(EventRing &ring, uint32_t symbol = 0) : ring_(&ring), symbol_(symbol) {}
+
+    void onTrade(const Trade &t) {
+        ExecutionEvent e;
+        e.type = ExecutionEvent::TRADE;
+        e.symbol = symbol_;
+        e.trade = t;
+        ring_->publish(e);
+    }
+
+    void onAck(const Ack &a) {
+        ExecutionEvent e;
+        e.type = ExecutionEvent::ACK;
+        e.symbol = symbol_;
+        e.ack = a;
+        ring_->publish(e);
+    }
+
+    void onCancel(const Cancel &c) {
+        ExecutionEvent e;
+        e.type = ExecutionEvent::CANCEL;
+        e.symbol = symbol_;
+        e.cancel = c;
+        ring_->publish(e);
+    }
+
+    void onReject(const Reject &r) {
+        ExecutionEvent e;
+        e.type = ExecutionEvent::REJECT;
+        e.symbol = symbol_;
+        e.reject = r;
+        ring_->publish(e);
+    }
+
+  private:
+    EventRing *ring_;
+    uint32_t symbol_;
+};
+
+// The book reports every add, fill, cancel and reject to EventSink, which must provide
+// onTrade/onAck/onCancel/onReject. Sinks are called inline from the matching loop.
+template <typename EventSink> class BasicOrderBook : public OrderBookTypes {
+  private:
+    using OrderHandle = uint32_t;
+    static constexpr OrderHandle NULL_HANDLE = UINT32_MAX;
+
+    // Pool node, linked into its price level's FIFO by pool indices
+    struct Order {
+        int orderID;
+        double price;
+        int quantity;
+        long long timestamp;
+        Side side;
+        OrderHandle prev;
+        OrderHandle next;
+    };
+
+    // Intrusive FIFO of pooled orders at one price, with its aggregates kept up to date
+    struct PriceLevel {
+        OrderHandle head = NULL_HANDLE;
+        OrderHandle tail = NULL_HANDLE;
+        long long totalQuantity = 0;
+        int orderCount = 0;
+
+        bool empty() const {
+            return head == NULL_HANDLE;
+        }
+    };
+
+    // Open-addressing map from order ID to pool handle. Linear probing with backward-shift
+    // deletion keeps it tombstone-free, and it only allocates when it has to grow.
+    class OrderIndex {
+      public:
+        OrderIndex() {
+            rebuild(16);
+        }
+
+        void reserve(size_t count) {
+            if (count * 2 > slots_.size()) rebuild(std::bit_ceil(count * 2));
+        }
+
+        OrderHandle find(int orderID) const {
+            for (size_t i = bucket(orderID);; i = (i + 1) & mask_) {
+                const Slot &slot = slots_[i];
+                if (slot.handle == NULL_HANDLE) return NULL_HANDLE;
+                if (slot.orderID == orderID) return slot.handle;
+            }
+        }
+
+        void insert(int orderID, OrderHandle handle) {
+            if ((size_ + 1) * 2 > slots_.size()) rebuild(slots_.size() * 2);
+            for (size_t i = bucket(orderID);; i = (i + 1) & mask_) {
+                Slot &slot = slots_[i];
+                if (slot.handle == NULL_HANDLE) {
+                    slot = {orderID, handle};
+                    ++size_;
+                    return;
+                }
+                if (slot.orderID == orderID) {
+                    slot.handle = handle;
+                    return;
+                }
+            }
+        }
+
+        void erase(int orderID) {
+            size_t i = bucket(orderID);
+            while (slots_[i].orderID != orderID || slots_[i].handle == NULL_HANDLE) {
+                if (slots_[i].handle == NULL_HANDLE) return;
+                i = (i + 1) & mask_;
+            }
+            // Shift later members of the probe chain back into the hole
+            for (size_t j = (i + 1) & mask_; slots_[j].handle != NULL_HANDLE; j = (j + 1) & mask_) {
+                size_t home = bucket(slots_[j].orderID);
+                if (((j - home) & mask_) >= ((j - i) & mask_)) {
+                    slots_[i] = slots_[j];
+                    i = j;
+                }
+            }
+            slots_[i].handle = NULL_HANDLE;
+            --size_;
+        }
+
+      private:
+        struct Slot {
+            int orderID;
+            OrderHandle handle;
+        };
+
+        std::vector<Slot> slots_;
+        size_t mask_ = 0;
+        size_t size_ = 0;
+
+        size_t bucket(int orderID) const {
+            return (static_cast<uint32_t>(orderID) * 0x9E3779B1u) & mask_;
+        }
+
+        void rebuild(size_t capacity) {
+            std::vector<Slot> old(capacity, Slot{0, NULL_HANDLE});
+            old.swap(slots_);
+            mask_ = capacity - 1;
+            size_ = 0;
+            for (const Slot &slot : old) {
+                if (slot.handle != NULL_HANDLE) insert(slot.orderID, slot.handle);
+            }
+        }
+    };
+
+    // Hierarchical occupancy bitmap over the ladder slots. Each bit of level L+1 says whether the
+    // matching 64-bit word of level L is non-zero, so the top level is a single word and finding
+    // the next occupied slot in either direction costs one word per level.
+    class LevelIndex {
+      public:
+        static constexpr size_t npos = SIZE_MAX;
+
+        void resize(size_t slots) {
+            levels_.clear();
+            do {
+                slots = (slots + 63) / 64;
+                levels_.emplace_back(slots, 0);
+            } while (slots > 1);
+        }
+
+        void set(size_t i) {
+            for (auto &words : levels_) {
+                uint64_t &word = words[i >> 6];
+                bool wasEmpty = word == 0;
+                word |= uint64_t{1} << (i & 63);
+                if (!wasEmpty) break;
+                i >>= 6;
+            }
+        }
+
+        void clear(size_t i) {
+            for (auto &words : levels_) {
+                uint64_t &word = words[i >> 6];
+                word &= ~(uint64_t{1} << (i & 63));
+                if (word != 0) break;
+                i >>= 6;
+            }
+        }
+
+        // Lowest occupied slot >= i, or npos
+        size_t findNext(size_t i) const {
+            size_t level = 0;
+            while (true) {
+                if (level == levels_.size() || (i >> 6) >= levels_[level].size()) return npos;
+                size_t w = i >> 6;
+                uint64_t bits = levels_[level][w] & (~uint64_t{0} << (i & 63));
+                if (bits) {
+                    i = (w << 6) | std::countr_zero(bits);
+                    break;
+                }
+                i = w + 1;
+                ++level;
+            }
+            while (level > 0) {
+                --level;
+                i = (i << 6) | std::countr_zero(levels_[level][i]);
+            }
+            return i;
+        }
+
+        // Highest occupied slot <= i, or npos
+        size_t findPrev(size_t i) const {
+            size_t level = 0;
+            while (true) {
+                if (level == levels_.size()) return npos;
+                size_t w = i >> 6;
+                uint64_t mask = (i & 63) == 63 ? ~uint64_t{0} : (uint64_t{1} << ((i & 63) + 1)) - 1;
+                uint64_t bits = levels_[level][w] & mask;
+                if (bits) {
+                    i = (w << 6) | (63 - std::countl_zero(bits));
+                    break;
+                }
+                if (w == 0) return npos;
+                i = w - 1;
+                ++level;
+            }
+            while (level > 0) {
+                --level;
+                i = (i << 6) | (63 - std::countl_zero(levels_[level][i]));
+            }
+            return i;
+        }
+
+      private:
+        std::vector<std::vector<uint64_t>> levels_;
+    };
+
+    std::map<double, PriceLevel, std::greater<double>> bids;
+    std::map<double, PriceLevel> asks;
+
+    // Price-ladder mode: prices are integer multiples of tickSize and levels live in contiguous
+    // arrays indexed by tick offset from the bottom of the band
+    bool ladderMode;
+    double ticksPerUnit;
+    long long minTick;
+    size_t numLevels;
+    std::vector<PriceLevel> bidLevels;
+    std::vector<PriceLevel> askLevels;
+    LevelIndex bidIndex;
+    LevelIndex askIndex;
+
+    // Resting orders live in one slab; released nodes are chained through `next`
+    std::vector<Order> orders;
+    OrderHandle freeList;
+
+    OrderIndex orderLocation;
+
+    double bestBid;
+    double bestAsk;
+
+    long long currentTimestamp;
+
+    // Ring of the most recent level changes for incremental depth consumers
+    static constexpr size_t LEVEL_UPDATE_CAPACITY = 4096;
+    std::vector<LevelUpdate> levelUpdates;
+    uint64_t sequence;
+
+    EventSink sink_;
+
+    // Convert a price to its ladder slot; fails if it is outside the band or off the tick grid
+    bool priceToTick(double price, size_t &tick) const {
+        double ticks = price * ticksPerUnit;
+        long long t = std::llround(ticks) - minTick;
+        if (t < 0 || t >= static_cast<long long>(numLevels) ||
+            std::fabs(ticks - std::round(ticks)) > 1e-6) {
+            return false;
+        }
+        tick = static_cast<size_t>(t);
+        return true;
+    }
+
+    // Dividing by ticksPerUnit gives back the same double as a decimal literal like 100.25
+    double tickToPrice(size_t tick) const {
+        return static_cast<double>(minTick + static_cast<long long>(tick)) / ticksPerUnit;
+    }
+
+    void updateBestPrices() {
+        if (ladderMode) {
+            size_t bidTick = bidIndex.findPrev(numLevels - 1);
+            size_t askTick = askIndex.findNext(0);
+            bestBid = bidTick == LevelIndex::npos ? 0.0 : tickToPrice(bidTick);
+            bestAsk = askTick == LevelIndex::npos ? DBL_MAX : tickToPrice(askTick);
+            return;
+        }
+        bestBid = bids.empty() ? 0.0 : bids.begin()->first;
+        bestAsk = asks.empty() ? DBL_MAX : asks.begin()->first;
+    }
+
+    // Take a node from the free list, growing the slab only when the pool is exhausted
+    OrderHandle allocateOrder() {
+        if (freeList != NULL_HANDLE) {
+            OrderHandle handle = freeList;
+            freeList = orders[handle].next;
+            return handle;
+        }
+        orders.emplace_back();
+        return static_cast<OrderHandle>(orders.size() - 1);
+    }
+
+    void releaseOrder(OrderHandle handle) {
+        orders[handle].next = freeList;
+        freeList = handle;
+    }
+
+    void pushBack(PriceLevel &level, OrderHandle handle) {
+        Order &order = orders[handle];
+        level.totalQuantity += order.quantity;
+        level.orderCount++;
+        order.prev = level.tail;
+        order.next = NULL_HANDLE;
+        if (level.tail != NULL_HANDLE) {
+            orders[level.tail].next = handle;
+        } else {
+            level.head = handle;
+        }
+        level.tail = handle;
+    }
+
+    void unlink(PriceLevel &level, OrderHandle handle) {
+        Order &order = orders[handle];
+        level.totalQuantity -= order.quantity;
+        level.orderCount--;
+        if (order.prev != NULL_HANDLE) {
+            orders[order.prev].next = order.next;
+        } else {
+            level.head = order.next;
+        }
+        if (order.next != NULL_HANDLE) {
+            orders[order.next].prev = order.prev;
+        } else {
+            level.tail = order.prev;
+        }
+    }
+
+    // Append the new state of a level to the update ring
+    void recordLevel(Side side, double price, const PriceLevel &level) {
+        ++sequence;
+        levelUpdates[sequence & (LEVEL_UPDATE_CAPACITY - 1)] = {
+            sequence, side, price, level.totalQuantity, level.orderCount};
+    }
+
+    // Fill the incoming order against one price level in FIFO order
+    void matchLevel(PriceLevel &level, double levelPrice, Side side, int &quantity, int orderID) {
+        while (quantity > 0 && !level.empty()) {
+            OrderHandle handle = level.head;
+            Order &resting = orders[handle];
+            int tradeQty = std::min(quantity, resting.quantity);
+            quantity -= tradeQty;
+            resting.quantity -= tradeQty;
+            level.totalQuantity -= tradeQty;
+
+            sink_.onTrade({orderID, resting.orderID, side, resting.price, tradeQty});
+
+            if (resting.quantity == 0) {
+                orderLocation.erase(resting.orderID);
+                unlink(level, handle);
+                releaseOrder(handle);
+            }
+        }
+        recordLevel(side == BUY ? SELL : BUY, levelPrice, level);
+    }
+
+    void matchOrders(Side side, double price, int &quantity, int orderID) {
+        if (side == BUY) {
+            while (quantity > 0 && !asks.empty() && asks.begin()->first <= price) {
+                auto &askLevel = asks.begin()->second;
+                matchLevel(askLevel, asks.begin()->first, side, quantity, orderID);
+                if (askLevel.empty()) {
+                    asks.erase(asks.begin());
+                }
+            }
+        } else {
+            while (quantity > 0 && !bids.empty() && bids.begin()->first >= price) {
+                auto &bidLevel = bids.begin()->second;
+                matchLevel(bidLevel, bids.begin()->first, side, quantity, orderID);
+                if (bidLevel.empty()) {
+                    bids.erase(bids.begin());
+                }
+            }
+        }
+    }
+
+    // Ladder sweep: walk occupied slots from the best price towards the limit tick
+    void matchLadder(Side side, size_t limitTick, int &quantity, int orderID) {
+        if (side == BUY) {
+            for (size_t t = askIndex.findNext(0);
+                 quantity > 0 && t != LevelIndex::npos && t <= limitTick;
+                 t = askIndex.findNext(t + 1)) {
+                matchLevel(askLevels[t], tickToPrice(t), side, quantity, orderID);
+                if (askLevels[t].empty()) askIndex.clear(t);
+            }
+        } else {
+            for (size_t t = bidIndex.findPrev(numLevels - 1);
+                 quantity > 0 && t != LevelIndex::npos && t >= limitTick;
+                 t = t == 0 ? LevelIndex::npos : bidIndex.findPrev(t - 1)) {
+                matchLevel(bidLevels[t], tickToPrice(t), side, quantity, orderID);
+                if (bidLevels[t].empty()) bidIndex.clear(t);
+            }
+        }
+    }
+
+    // Level a resting order joins, creating it if needed
+    PriceLevel &restingLevel(Side side, double price, size_t tick) {
+        if (ladderMode) {
+            if (side == BUY) {
+                bidIndex.set(tick);
+                return bidLevels[tick];
+            }
+            askIndex.set(tick);
+            return askLevels[tick];
+        }
+        return side == BUY ? bids[price] : asks[price];
+    }
+
+    // Level currently holding a resting order
+    PriceLevel &levelOf(const Order &order) {
+        if (ladderMode) {
+            size_t tick = 0;
+            priceToTick(order.price, tick);
+            return order.side == BUY ? bidLevels[tick] : askLevels[tick];
+        }
+        return order.side == BUY ? bids.find(order.price)->second
+                                 : asks.find(order.price)->second;
+    }
+
+    // Price a level is reported at: the ladder slot's price, or the map key
+    double levelPrice(const Order &order) const {
+        if (ladderMode) {
+            size_t tick = 0;
+            priceToTick(order.price, tick);
+            return tickToPrice(tick);
+        }
+        return order.price;
+    }
+
+    // Drop a level that has just become empty
+    void removeLevel(const Order &order) {
+        if (ladderMode) {
+            size_t tick = 0;
+            priceToTick(order.price, tick);
+            (order.side == BUY ? bidIndex : askIndex).clear(tick);
+        } else if (order.side == BUY) {
+            bids.erase(order.price);
+        } else {
+            asks.erase(order.price);
+        }
+    }
+
+    // Append a new resting order to the back of its price level
+    void restOrder(Side side, double price, int quantity, int orderID, size_t tick) {
+        OrderHandle handle = allocateOrder();
+        orders[handle] = {orderID, price, quantity, currentTimestamp,
+                          side,    NULL_HANDLE, NULL_HANDLE};
+        PriceLevel &level = restingLevel(side, price, tick);
+        pushBack(level, handle);
+        orderLocation.insert(orderID, handle);
+        recordLevel(side, levelPrice(orders[handle]), level);
+    }
+
+    // Visit the non-empty levels of one side from the best price outwards until fn returns false
+    template <typename Fn> void forEachLevelBestFirst(Side side, Fn &&fn) const {
+        if (ladderMode) {
+            if (side == BUY) {
+                for (size_t t = bidIndex.findPrev(numLevels - 1); t != LevelIndex::npos;
+                     t = t == 0 ? LevelIndex::npos : bidIndex.findPrev(t - 1)) {
+                    if (!fn(tickToPrice(t), bidLevels[t])) return;
+                }
+            } else {
+                for (size_t t = askIndex.findNext(0); t != LevelIndex::npos;
+                     t = askIndex.findNext(t + 1)) {
+                    if (!fn(tickToPrice(t), askLevels[t])) return;
+                }
+            }
+        } else if (side == BUY) {
+            for (const auto &level : bids) {
+                if (!fn(level.first, level.second)) return;
+            }
+        } else {
+            for (const auto &level : asks) {
+                if (!fn(level.first, level.second)) return;
+            }
+        }
+    }
+
+    // Visit the non-empty levels of one side from the highest price to the lowest
+    template <typename Fn> void forEachLevelDescending(Side side, Fn &&fn) const {
+        if (ladderMode) {
+            const LevelIndex &index = side == BUY ? bidIndex : askIndex;
+            const auto &levels = side == BUY ? bidLevels : askLevels;
+            for (size_t t = index.findPrev(numLevels - 1); t != LevelIndex::npos;
+                 t = t == 0 ? LevelIndex::npos : index.findPrev(t - 1)) {
+                fn(tickToPrice(t), levels[t]);
+            }
+        } else if (side == BUY) {
+            for (const auto &level : bids) {
+                fn(level.first, level.second);
+            }
+        } else {
+            for (auto it = asks.rbegin(); it != asks.rend(); ++it) {
+                fn(it->first, it->second);
+            }
+        }
+    }
+
+  public:
+    explicit BasicOrderBook(EventSink sink = EventSink())
+        : ladderMode(false), ticksPerUnit(0.0), minTick(0), numLevels(0), freeList(NULL_HANDLE),
+          bestBid(0.0), bestAsk(DBL_MAX), currentTimestamp(0),
+          levelUpdates(LEVEL_UPDATE_CAPACITY), sequence(0), sink_(std::move(sink)) {}
+
+    // Price-ladder mode: prices must be multiples of tickSize within [minPrice, maxPrice]
+    BasicOrderBook(double tickSize, double minPrice, double maxPrice,
+                   EventSink sink = EventSink())
+        : ladderMode(true), ticksPerUnit(0.0), minTick(0), numLevels(0), freeList(NULL_HANDLE),
+          bestBid(0.0), bestAsk(DBL_MAX), currentTimestamp(0),
+          levelUpdates(LEVEL_UPDATE_CAPACITY), sequence(0), sink_(std::move(sink)) {
+        numLevels = ladderLevels(tickSize, minPrice, maxPrice);
+        ticksPerUnit = 1.0 / tickSize;
+        minTick = static_cast<long long>(std::ceil(minPrice * ticksPerUnit - 1e-6));
+        bidLevels.resize(numLevels);
+        askLevels.resize(numLevels);
+        bidIndex.resize(numLevels);
+        askIndex.resize(numLevels);
+    }
+
+    // Levels a price ladder over [minPrice, maxPrice] needs; throws for the bands the
+    // price-ladder constructor rejects
+    static size_t ladderLevels(double tickSize, double minPrice, double maxPrice) {
+        if (!(tickSize > 0.0)) {
+            throw std::invalid_argument("Tick size must be positive");
+        }
+        if (!(maxPrice >= minPrice)) {
+            throw std::invalid_argument("Price band is empty");
+        }
+        double ticksPerUnit = 1.0 / tickSize;
+        long long minTick = static_cast<long long>(std::ceil(minPrice * ticksPerUnit - 1e-6));
+        long long maxTick = static_cast<long long>(std::floor(maxPrice * ticksPerUnit + 1e-6));
+        if (maxTick < minTick) {
+            throw std::invalid_argument("Price band contains no tick");
+        }
+        return static_cast<size_t>(maxTick - minTick) + 1;
+    }
+
+    // Add an order
+    void addOrder(Side side, double price, int quantity, int orderID) {
+        if (quantity <= 0) {
+            sink_.onReject({orderID, ADD, INVALID_QUANTITY, price});
+            return;
+        }
+
+        size_t tick = 0;
+        if (ladderMode && !priceToTick(price, tick)) {
+            sink_.onReject({orderID, ADD, INVALID_PRICE, price});
+            return;
+        }
+
+        currentTimestamp++;
+
+        if (ladderMode) {
+            matchLadder(side, tick, quantity, orderID);
+        } else {
+            matchOrders(side, price, quantity, orderID);
+        }
+
+        if (quantity > 0) {
+            restOrder(side, price, quantity, orderID, tick);
+            sink_.onAck({orderID, side, price, quantity, RESTING});
+        } else {
+            sink_.onAck({orderID, side, price, 0, FULLY_FILLED});
+        }
+        updateBestPrices();
+    }
+
+    // Cancel an order
+    bool cancelOrder(int orderID) {
+        OrderHandle handle = orderLocation.find(orderID);
+        if (handle == NULL_HANDLE) {
+            sink_.onReject({orderID, CANCEL, UNKNOWN_ORDER, 0.0});
+            return false;
+        }
+        const Order &order = orders[handle];
+        Cancel report{orderID, order.side, order.price, order.quantity};
+        PriceLevel &level = levelOf(order);
+        unlink(level, handle);
+        recordLevel(order.side, levelPrice(order), level);
+        if (level.empty()) {
+            removeLevel(order);
+        }
+        releaseOrder(handle);
+
+        orderLocation.erase(orderID);
+        sink_.onCancel(report);
+        updateBestPrices();
+        return true;
+    }
+
+    // Change the resting quantity of an order. Reducing it keeps time priority; increasing it
+    // sends the order to the back of its price level.
+    bool modifyOrder(int orderID, int newQuantity) {
+        if (newQuantity <= 0) {
+            sink_.onReject({orderID, MODIFY, INVALID_QUANTITY, 0.0});
+            return false;
+        }
+        OrderHandle handle = orderLocation.find(orderID);
+        if (handle == NULL_HANDLE) {
+            sink_.onReject({orderID, MODIFY, UNKNOWN_ORDER, 0.0});
+            return false;
+        }
+        Order &order = orders[handle];
+        PriceLevel &level = levelOf(order);
+        if (newQuantity > order.quantity) {
+            unlink(level, handle);
+            pushBack(level, handle);
+            order.timestamp = ++currentTimestamp;
+        }
+        level.totalQuantity += newQuantity - order.quantity;
+        order.quantity = newQuantity;
+        recordLevel(order.side, levelPrice(order), level);
+        sink_.onAck({orderID, order.side, order.price, newQuantity, MODIFIED});
+        return true;
+    }
+
+    EventSink &sink() {
+        return sink_;
+    }
+
+    // Top maxLevels levels of one side, best first, written into a caller buffer
+    size_t getDepth(Side side, DepthLevel *out, size_t maxLevels) const {
+        size_t count = 0;
+        if (maxLevels == 0) return 0;
+        forEachLevelBestFirst(side, [&](double price, const PriceLevel &level) {
+            out[count++] = {price, level.totalQuantity, level.orderCount};
+            return count < maxLevels;
+        });
+        return count;
+    }
+
+    // Orders resting at one price in time priority, written into a caller buffer
+    size_t getOrders(Side side, double price, OrderInfo *out, size_t maxOrders) const {
+        const PriceLevel *level = nullptr;
+        if (ladderMode) {
+            size_t tick = 0;
+            if (!priceToTick(price, tick)) return 0;
+            level = side == BUY ? &bidLevels[tick] : &askLevels[tick];
+        } else if (side == BUY) {
+            auto it = bids.find(price);
+            if (it != bids.end()) level = &it->second;
+        } else {
+            auto it = asks.find(price);
+            if (it != asks.end()) level = &it->second;
+        }
+        size_t count = 0;
+        OrderHandle h = level ? level->head : NULL_HANDLE;
+        for (; h != NULL_HANDLE && count < maxOrders; h = orders[h].next) {
+            out[count++] = {orders[h].orderID, orders[h].quantity, orders[h].timestamp};
+        }
+        return count;
+    }
+
+    // Sequence number of the latest level change
+    uint64_t getSequence() const {
+        return sequence;
+    }
+
+    // Level changes after sinceSequence, oldest first. Returns false if some of them have already
+    // been overwritten, in which case the caller should take a fresh getDepth() snapshot.
+    bool getLevelUpdates(uint64_t sinceSequence, LevelUpdate *out, size_t maxUpdates,
+                         size_t &count) const {
+        count = 0;
+        if (sinceSequence >= sequence) return true;
+        if (sequence - sinceSequence > LEVEL_UPDATE_CAPACITY) return false;
+        size_t pending = static_cast<size_t>(sequence - sinceSequence);
+        count = std::min(pending, maxUpdates);
+        for (size_t i = 0; i < count; ++i) {
+            out[i] = levelUpdates[(sinceSequence + 1 + i) & (LEVEL_UPDATE_CAPACITY - 1)];
+        }
+        return true;
+    }
+
+    // Preallocate room for this many resting orders so the hot path never allocates
+    void reserve(size_t maxOrders) {
+        orders.reserve(maxOrders);
+        orderLocation.reserve(maxOrders);
+    }
+
+    // Get best bid/ask in O(1)
+    double getBestBid() const {
+        return bestBid;
+    }
+    double getBestAsk() const {
+        return bestAsk;
+    }
+
+    // Display order book (for debugging)
+    void printOrderBook() const {
+        std::cout << "\n=== ORDER BOOK ===" << std::endl;
+
+        auto printLevel = [](double price, const PriceLevel &level) {
+            std::cout << "  $" << price << " | " << level.totalQuantity << " shares" << std::endl;
+        };
+
+        // Display asks in descending order (highest ask at top)
+        std::cout << "ASKS (SELL orders):" << std::endl;
+        forEachLevelDescending(SELL, printLevel);
+
+        std::cout << "---" << std::endl;
+        std::cout << "Best Ask: $" << (bestAsk == DBL_MAX ? 0 : bestAsk) << std::endl;
+        std::cout << "Best Bid: $" << bestBid << std::endl;
+        std::cout << "---" << std::endl;
+
+        // Display bids in descending order (highest bid at top)
+        std::cout << "BIDS (BUY orders):" << std::endl;
+        forEachLevelDescending(BUY, printLevel);
+        std::cout << "==================\n" << std::endl;
+    }
+};
+
+using OrderBook = BasicOrderBook<PrintingSink>;
+
+#endif
@@ -1,20 +1,153 @@
 #ifndef THREADSAFE_HPP
 #define THREADSAFE_HPP
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
 #include <mutex>
-#include <queue>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
 
-template <typename T> class ThreadSafeQueue {
+#include "LatencyHistogram.hpp"
+
+// Implementation selectors for ThreadSafeQueue
+struct MutexPolicy {};    // One mutex and two condition variables; supports every operation
+struct LockFreePolicy {}; // Vyukov-style bounded MPMC ring; threads only park when empty/full
+
+// What a stats policy has seen so far
+struct QueueStatsSnapshot {
+    uint64_t enqueued = 0;
+    uint64_t dequeued = 0;
+    uint64_t failedTryPush = 0;
+    size_t depth = 0; // Enqueued minus dequeued
+    size_t highWater = 0;
+    LatencyHistogram pushBlockedNs; // Producers waiting for room
+    LatencyHistogram popBlockedNs;  // Consumers waiting for an item
+    LatencyHistogram latencyNs;     // Push to pop, per item
+};
+
+// Stats policies for ThreadSafeQueue. The queue calls these hooks; NoQueueStats makes them
+// empty, takes no timestamps and stores none, so it costs nothing.
+struct NoQueueStats {
+    static constexpr bool enabled = false;
+
+    static uint64_t now() {
+        return 0;
+    }
+    void onPush(size_t, size_t) {}
+    void onPop(size_t) {}
+    void onFailedPush() {}
+    void onPushBlocked(uint64_t) {}
+    void onPopBlocked(uint64_t) {}
+    void onLatency(uint64_t) {}
+};
+
+// Counts, high-water depth and wait/latency histograms on relaxed atomics, so the lock-free
+// queue can update them without a lock. Producer and consumer counters sit on separate lines.
+class QueueStats {
+  public:
+    static constexpr bool enabled = true;
+
+    static uint64_t now() {
+        return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                         std::chrono::steady_clock::now().time_since_epoch())
+                                         .count());
+    }
+
+    // items were added, leaving depth items queued
+    void onPush(size_t items, size_t depth) {
+        enqueued_.fetch_add(items, std::memory_order_relaxed);
+        size_t high = highWater_.load(std::memory_order_relaxed);
+        while (depth > high &&
+               !highWater_.compare_exchange_weak(high, depth, std::memory_order_relaxed)) {
+        }
+    }
+
+    void onPop(size_t items) {
+        dequeued_.fetch_add(items, std::memory_order_relaxed);
+    }
+
+    void onFailedPush() {
+        failedTryPush_.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    void onPushBlocked(uint64_t ns) {
+        pushBlocked_.record(ns);
+    }
+
+    void onPopBlocked(uint64_t ns) {
+        popBlocked_.record(ns);
+    }
+
+    void onLatency(uint64_t ns) {
+        latency_.record(ns);
+    }
+
+    QueueStatsSnapshot snapshot() const {
+        QueueStatsSnapshot s;
+        // Dequeued first, so the depth computed from a later enqueued count cannot go negative
+        s.dequeued = dequeued_.load(std::memory_order_relaxed);
+        s.enqueued = enqueued_.load(std::memory_order_relaxed);
+        s.failedTryPush = failedTryPush_.load(std::memory_order_relaxed);
+        s.depth = s.enqueued >= s.dequeued ? static_cast<size_t>(s.enqueued - s.dequeued) : 0;
+        s.highWater = highWater_.load(std::memory_order_relaxed);
+        s.pushBlockedNs = pushBlocked_.snapshot();
+        s.popBlockedNs = popBlocked_.snapshot();
+        s.latencyNs = latency_.snapshot();
+        return s;
+    }
+
+  private:
+    alignas(64) std::atomic<uint64_t> enqueued_{0};
+    std::atomic<size_t> highWater_{0};
+    std::atomic<uint64_t> failedTryPush_{0};
+    AtomicLatencyHistogram pushBlocked_;
+    alignas(64) std::atomic<uint64_t> dequeued_{0};
+    AtomicLatencyHistogram popBlocked_;
+    AtomicLatencyHistogram latency_;
+};
+
+// Bounded blocking queue on a ring preallocated at construction, so pushing never allocates.
+// Waiters are counted under the lock and the condition variables are only signalled when
+// somebody is actually waiting.
+//
+// Stats is a stats policy: NoQueueStats (free) or QueueStats, read back through stats().
+template <typename T, typename Policy = MutexPolicy, typename Stats = NoQueueStats>
+class ThreadSafeQueue {
   private:
-    std::queue<T> queue_;
+    std::allocator<T> allocator_;
+    T *buffer_;
+    size_t head_;  // Slot of the oldest item
+    size_t count_; // Items in the ring
     mutable std::mutex mutex_;
     std::condition_variable notEmpty_;
     std::condition_variable notFull_;
+    size_t waitingPop_;  // Consumers blocked on notEmpty_
+    size_t waitingPush_; // Producers blocked on notFull_
     size_t max_size_;
     bool shutdown_;
+    struct NoStamps {};
+    // Push times, parallel to buffer_, kept only when stats are enabled
+    [[no_unique_address]] std::conditional_t<Stats::enabled, std::unique_ptr<uint64_t[]>,
+                                             NoStamps> stamps_;
+    [[no_unique_address]] Stats stats_;
 
+    template <typename U> void pushLocked(U &&item, uint64_t stamp);
+    T popLocked(uint64_t now);
+    void waitForRoom(std::unique_lock<std::mutex> &lock);
+    void waitForItem(std::unique_lock<std::mutex> &lock);
+    template <typename Clock, typename Duration>
+    void waitForItemUntil(std::unique_lock<std::mutex> &lock,
+                          const std::chrono::time_point<Clock, Duration> &deadline);
+    void wakeConsumers(size_t items);
+    void wakeProducers(size_t slots);
 
   public:
     explicit ThreadSafeQueue(size_t maxSize = 1000);
@@ -37,12 +170,34 @@ template <typename T> class ThreadSafeQueue {
     // Move version of tryPush
     bool tryPush(T &&item);
 
+    // Add all items, as many per lock acquisition as there is room for (blocks while full);
+    // throws like push() on shutdown, with the items that fit so far already queued
+    void pushBulk(std::span<const T> items);
+
+    // Non-blocking version; returns how many items from the front of items were added
+    size_t tryPushBulk(std::span<const T> items);
+
     // Get an element (blocks if empty)
     T pop();
 
     // Non-blocking version (returns false if empty)
     bool tryPop(T &item);
 
+    // Wait at most timeout for an element; throws like pop() once shut down and drained
+    template <typename Rep, typename Period>
+    std::optional<T> popFor(const std::chrono::duration<Rep, Period> &timeout);
+
+    // Wait until deadline for an element; false on timeout or once shut down and drained
+    template <typename Clock, typename Duration>
+    bool tryPopUntil(T &item, const std::chrono::time_point<Clock, Duration> &deadline);
+
+    // Move up to maxN elements into out under one lock (blocks until at least one is there);
+    // returns the count, and throws like pop() once shut down and drained
+    size_t popBulk(std::span<T> out, size_t maxN = SIZE_MAX);
+
+    // Non-blocking version; returns 0 if empty
+    size_t tryPopBulk(std::span<T> out, size_t maxN = SIZE_MAX);
+
     // Current size
     size_t size() const;
 
@@ -54,6 +209,648 @@ template <typename T> class ThreadSafeQueue {
 
     // Check if shutdown
     bool isShutdown() const;
+
+    // What the stats policy has recorded
+    QueueStatsSnapshot stats() const
+        requires Stats::enabled;
 };
 
-#endif
\ No newline at end of file
+template <typename T, typename Policy, typename Stats>
+ThreadSafeQueue<T, Policy, Stats>::ThreadSafeQueue(size_t maxSize)
+    : buffer_(maxSize ? allocator_.allocate(maxSize) : nullptr), head_(0), count_(0),
+      waitingPop_(0), waitingPush_(0), max_size_(maxSize), shutdown_(false) {
+    if constexpr (Stats::enabled) {
+        stamps_ = std::make_unique<uint64_t[]>(maxSize);
+    }
+}
+
+template <typename T, typename Policy, typename Stats>
+ThreadSafeQueue<T, Policy, Stats>::~ThreadSafeQueue() {
+    shutdown();
+    while (count_) {
+        popLocked(0);
+    }
+    if (buffer_) allocator_.deallocate(buffer_, max_size_);
+}
+
+// Ring helpers; the caller holds mutex_ and has checked for room or an item
+template <typename T, typename Policy, typename Stats>
+template <typename U>
+void ThreadSafeQueue<T, Policy, Stats>::pushLocked(U &&item, uint64_t stamp) {
+    size_t tail = head_ + count_;
+    if (tail >= max_size_) tail -= max_size_;
+    std::construct_at(buffer_ + tail, std::forward<U>(item));
+    if constexpr (Stats::enabled) stamps_[tail] = stamp;
+    count_++;
+}
+
+template <typename T, typename Policy, typename Stats>
+T ThreadSafeQueue<T, Policy, Stats>::popLocked(uint64_t now) {
+    if constexpr (Stats::enabled) {
+        if (now) stats_.onLatency(now - stamps_[head_]);
+    }
+    T item = std::move(buffer_[head_]);
+    std::destroy_at(buffer_ + head_);
+    if (++head_ == max_size_) head_ = 0;
+    count_--;
+    return item;
+}
+
+// Block on notFull_ until there is room or the queue shuts down
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::waitForRoom(std::unique_lock<std::mutex> &lock) {
+    if (count_ < max_size_ || shutdown_) return;
+    uint64_t start = Stats::now();
+    waitingPush_++;
+    notFull_.wait(lock, [this]() { return count_ < max_size_ || shutdown_; });
+    waitingPush_--;
+    stats_.onPushBlocked(Stats::now() - start);
+}
+
+// Block on notEmpty_ until there is an item or the queue shuts down
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::waitForItem(std::unique_lock<std::mutex> &lock) {
+    if (count_ != 0 || shutdown_) return;
+    uint64_t start = Stats::now();
+    waitingPop_++;
+    notEmpty_.wait(lock, [this]() { return count_ != 0 || shutdown_; });
+    waitingPop_--;
+    stats_.onPopBlocked(Stats::now() - start);
+}
+
+// Same, giving up at deadline
+template <typename T, typename Policy, typename Stats>
+template <typename Clock, typename Duration>
+void ThreadSafeQueue<T, Policy, Stats>::waitForItemUntil(
+    std::unique_lock<std::mutex> &lock, const std::chrono::time_point<Clock, Duration> &deadline) {
+    if (count_ != 0 || shutdown_) return;
+    uint64_t start = Stats::now();
+    waitingPop_++;
+    notEmpty_.wait_until(lock, deadline, [this]() { return count_ != 0 || shutdown_; });
+    waitingPop_--;
+    stats_.onPopBlocked(Stats::now() - start);
+}
+
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::wakeConsumers(size_t items) {
+    if (waitingPop_ == 0 || items == 0) return;
+    if (items > 1) {
+        notEmpty_.notify_all();
+    } else {
+        notEmpty_.notify_one();
+    }
+}
+
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::wakeProducers(size_t slots) {
+    if (waitingPush_ == 0 || slots == 0) return;
+    if (slots > 1) {
+        notFull_.notify_all();
+    } else {
+        notFull_.notify_one();
+    }
+}
+
+// Add an element (blocks if full)
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::push(const T &item) {
+    uint64_t stamp = Stats::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitForRoom(lock);
+    if (shutdown_) {
+        throw std::runtime_error("Queue is shutting down.");
+    }
+    pushLocked(item, stamp);
+    stats_.onPush(1, count_);
+    wakeConsumers(1);
+}
+
+// Move version of push
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::push(T &&item) {
+    uint64_t stamp = Stats::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitForRoom(lock);
+    if (shutdown_) {
+        throw std::runtime_error("Queue is shutting down.");
+    }
+    pushLocked(std::move(item), stamp);
+    stats_.onPush(1, count_);
+    wakeConsumers(1);
+}
+
+// Non-blocking version (returns false if full)
+template <typename T, typename Policy, typename Stats>
+bool ThreadSafeQueue<T, Policy, Stats>::tryPush(const T &item) {
+    uint64_t stamp = Stats::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ >= max_size_ || shutdown_) {
+        stats_.onFailedPush();
+        return false;
+    }
+
+    pushLocked(item, stamp);
+    stats_.onPush(1, count_);
+    wakeConsumers(1);
+    return true;
+}
+
+// Move version of tryPush
+template <typename T, typename Policy, typename Stats>
+bool ThreadSafeQueue<T, Policy, Stats>::tryPush(T &&item) {
+    uint64_t stamp = Stats::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ >= max_size_ || shutdown_) {
+        stats_.onFailedPush();
+        return false;
+    }
+
+    pushLocked(std::move(item), stamp);
+    stats_.onPush(1, count_);
+    wakeConsumers(1);
+    return true;
+}
+
+// Add all items, as many per lock acquisition as there is room for (blocks while full)
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::pushBulk(std::span<const T> items) {
+    uint64_t stamp = Stats::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (!items.empty()) {
+        waitForRoom(lock);
+        if (shutdown_) {
+            throw std::runtime_error("Queue is shutting down.");
+        }
+        size_t n = std::min(items.size(), max_size_ - count_);
+        for (size_t i = 0; i < n; ++i) {
+            pushLocked(items[i], stamp);
+        }
+        items = items.subspan(n);
+        stats_.onPush(n, count_);
+        wakeConsumers(n);
+    }
+}
+
+// Non-blocking version; returns how many items from the front of items were added
+template <typename T, typename Policy, typename Stats>
+size_t ThreadSafeQueue<T, Policy, Stats>::tryPushBulk(std::span<const T> items) {
+    uint64_t stamp = Stats::now();
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = shutdown_ ? 0 : std::min(items.size(), max_size_ - count_);
+    if (n < items.size()) stats_.onFailedPush();
+    for (size_t i = 0; i < n; ++i) {
+        pushLocked(items[i], stamp);
+    }
+    stats_.onPush(n, count_);
+    wakeConsumers(n);
+    return n;
+}
+
+// Get an element (blocks if empty)
+template <typename T, typename Policy, typename Stats> T ThreadSafeQueue<T, Policy, Stats>::pop() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitForItem(lock);
+
+    if (shutdown_ && count_ == 0) {
+        throw std::runtime_error("Queue is shutting down.");
+    }
+
+    T item = popLocked(Stats::now());
+    stats_.onPop(1);
+    wakeProducers(1);
+    return item;
+}
+
+// Non-blocking version (returns false if empty)
+template <typename T, typename Policy, typename Stats>
+bool ThreadSafeQueue<T, Policy, Stats>::tryPop(T &item) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (count_ == 0) return false;
+
+    item = popLocked(Stats::now());
+    stats_.onPop(1);
+    wakeProducers(1);
+    return true;
+}
+
+// Wait at most timeout for an element; throws like pop() once shut down and drained
+template <typename T, typename Policy, typename Stats>
+template <typename Rep, typename Period>
+std::optional<T>
+ThreadSafeQueue<T, Policy, Stats>::popFor(const std::chrono::duration<Rep, Period> &timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitForItemUntil(lock, std::chrono::steady_clock::now() + timeout);
+
+    if (count_ == 0) {
+        if (shutdown_) throw std::runtime_error("Queue is shutting down.");
+        return std::nullopt;
+    }
+
+    std::optional<T> item(popLocked(Stats::now()));
+    stats_.onPop(1);
+    wakeProducers(1);
+    return item;
+}
+
+// Wait until deadline for an element; false on timeout or once shut down and drained
+template <typename T, typename Policy, typename Stats>
+template <typename Clock, typename Duration>
+bool ThreadSafeQueue<T, Policy, Stats>::tryPopUntil(
+    T &item, const std::chrono::time_point<Clock, Duration> &deadline) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitForItemUntil(lock, deadline);
+    if (count_ == 0) return false;
+
+    item = popLocked(Stats::now());
+    stats_.onPop(1);
+    wakeProducers(1);
+    return true;
+}
+
+// Move up to maxN elements into out under one lock (blocks until at least one is there)
+template <typename T, typename Policy, typename Stats>
+size_t ThreadSafeQueue<T, Policy, Stats>::popBulk(std::span<T> out, size_t maxN) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    waitForItem(lock);
+
+    if (shutdown_ && count_ == 0) {
+        throw std::runtime_error("Queue is shutting down.");
+    }
+
+    size_t n = std::min({out.size(), maxN, count_});
+    uint64_t now = Stats::now();
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = popLocked(now);
+    }
+    stats_.onPop(n);
+    wakeProducers(n);
+    return n;
+}
+
+// Non-blocking version; returns 0 if empty
+template <typename T, typename Policy, typename Stats>
+size_t ThreadSafeQueue<T, Policy, Stats>::tryPopBulk(std::span<T> out, size_t maxN) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t n = std::min({out.size(), maxN, count_});
+    uint64_t now = Stats::now();
+    for (size_t i = 0; i < n; ++i) {
+        out[i] = popLocked(now);
+    }
+    stats_.onPop(n);
+    wakeProducers(n);
+    return n;
+}
+
+// Current size
+template <typename T, typename Policy, typename Stats>
+size_t ThreadSafeQueue<T, Policy, Stats>::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_;
+}
+
+// Check if queue is empty
+template <typename T, typename Policy, typename Stats>
+bool ThreadSafeQueue<T, Policy, Stats>::empty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return count_ == 0;
+}
+
+// Clean shutdown (for thread termination)
+template <typename T, typename Policy, typename Stats>
+void ThreadSafeQueue<T, Policy, Stats>::shutdown() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    shutdown_ = true;
+    notEmpty_.notify_all();
+    notFull_.notify_all();
+}
+
+// Check if shutdown
+template <typename T, typename Policy, typename Stats>
+bool ThreadSafeQueue<T, Policy, Stats>::isShutdown() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return shutdown_;
+}
+
+template <typename T, typename Policy, typename Stats>
+QueueStatsSnapshot ThreadSafeQueue<T, Policy, Stats>::stats() const
+    requires Stats::enabled
+{
+    return stats_.snapshot();
+}
+
+// Lets threads sleep until another thread signals progress, without a lock on the fast path.
+// The state word is epoch << 32 | registered waiters. A waiter registers, re-checks its
+// condition, then sleeps until the epoch moves; a signaller only does anything when someone
+// is registered, and then bumps the epoch and clears the count in one step, so a woken waiter
+// that has not run yet does not make every later signal pay for another wake.
+class EventCount {
+  public:
+    uint32_t prepareWait() {
+        uint64_t prev = state_.fetch_add(1, std::memory_order_seq_cst);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        return static_cast<uint32_t>(prev >> 32);
+    }
+
+    // Withdraw a registration, unless a signal already consumed it
+    void cancelWait(uint32_t key) {
+        uint64_t state = state_.load(std::memory_order_relaxed);
+        while (static_cast<uint32_t>(state >> 32) == key &&
+               !state_.compare_exchange_weak(state, state - 1, std::memory_order_relaxed)) {
+        }
+    }
+
+    void wait(uint32_t key) {
+        uint64_t state = state_.load(std::memory_order_acquire);
+        while (static_cast<uint32_t>(state >> 32) == key) {
+            state_.wait(state, std::memory_order_acquire);
+            state = state_.load(std::memory_order_acquire);
+        }
+    }
+
+    // Wake every registered waiter
+    void notify() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        uint64_t state = state_.load(std::memory_order_relaxed);
+        while (state & WAITER_MASK) {
+            uint64_t next = ((state >> 32) + 1) << 32;
+            if (state_.compare_exchange_weak(state, next, std::memory_order_release,
+                                             std::memory_order_relaxed)) {
+                state_.notify_all();
+                return;
+            }
+        }
+    }
+
+  private:
+    static constexpr uint64_t WAITER_MASK = 0xFFFFFFFFull;
+
+    std::atomic<uint64_t> state_{0};
+};
+
+// Lock-free bounded MPMC queue (Dmitry Vyukov's design). Each cell has a sequence number that
+// says whether it is free for the producer at a given position or full for the consumer at it,
+// so producers and consumers only contend on their own position counter. Threads spin briefly
+// and then park on an EventCount when the queue is full or empty.
+//
+// push/tryPush/pop/tryPop/size/empty/shutdown behave as in the mutex version; the bulk and
+// timed operations are only provided by MutexPolicy. size() is a snapshot that can be stale.
+template <typename T, typename Stats> class ThreadSafeQueue<T, LockFreePolicy, Stats> {
+  private:
+    struct NoStamp {};
+
+    struct Cell {
+        std::atomic<size_t> sequence;
+        alignas(T) unsigned char storage[sizeof(T)];
+        [[no_unique_address]] std::conditional_t<Stats::enabled, uint64_t, NoStamp> stamp;
+
+        T *item() {
+            return std::launder(reinterpret_cast<T *>(storage));
+        }
+    };
+
+    static constexpr int SPINS = 64;
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t max_size_;
+    size_t mask_; // max_size_ - 1 when it is a power of two, otherwise 0
+    alignas(64) std::atomic<size_t> enqueuePos_{0};
+    alignas(64) std::atomic<size_t> dequeuePos_{0};
+    alignas(64) std::atomic<bool> shutdown_{false};
+    EventCount notEmpty_;
+    EventCount notFull_;
+    [[no_unique_address]] Stats stats_;
+
+    size_t cellIndex(size_t pos) const {
+        return mask_ ? pos & mask_ : pos % max_size_;
+    }
+
+    template <typename U> bool enqueue(U &&item, uint64_t stamp);
+    bool dequeue(T &item);
+    template <typename U> void pushBlocking(U &&item);
+    template <typename U> bool tryPushImpl(U &&item);
+
+  public:
+    explicit ThreadSafeQueue(size_t maxSize = 1000);
+
+    ~ThreadSafeQueue();
+
+    ThreadSafeQueue(const ThreadSafeQueue &) = delete;
+    ThreadSafeQueue &operator=(const ThreadSafeQueue &) = delete;
+
+    void push(const T &item);
+    void push(T &&item);
+    bool tryPush(const T &item);
+    bool tryPush(T &&item);
+    T pop();
+    bool tryPop(T &item);
+    size_t size() const;
+    bool empty() const;
+    void shutdown();
+    bool isShutdown() const;
+
+    QueueStatsSnapshot stats() const
+        requires Stats::enabled;
+};
+
+template <typename T, typename Stats>
+ThreadSafeQueue<T, LockFreePolicy, Stats>::ThreadSafeQueue(size_t maxSize)
+    : max_size_(maxSize), mask_((maxSize & (maxSize - 1)) == 0 ? maxSize - 1 : 0) {
+    // With one cell the "written" and "free for the next lap" sequence numbers would coincide
+    if (maxSize < 2) {
+        throw std::invalid_argument("Lock-free queue needs a capacity of at least 2");
+    }
+    cells_ = std::make_unique<Cell[]>(maxSize);
+    for (size_t i = 0; i < maxSize; ++i) {
+        cells_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+template <typename T, typename Stats>
+ThreadSafeQueue<T, LockFreePolicy, Stats>::~ThreadSafeQueue() {
+    shutdown();
+    T item;
+    while (dequeue(item)) {
+    }
+}
+
+// Claim the cell at the producer position: it is free for us when its sequence equals the
+// position, still holds last lap's item when it is behind
+template <typename T, typename Stats>
+template <typename U>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::enqueue(U &&item, uint64_t stamp) {
+    size_t pos = enqueuePos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell = &cells_[cellIndex(pos)];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos);
+        if (diff == 0) {
+            if (enqueuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // Full
+        } else {
+            pos = enqueuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    std::construct_at(cell->item(), std::forward<U>(item));
+    if constexpr (Stats::enabled) cell->stamp = stamp;
+    cell->sequence.store(pos + 1, std::memory_order_release);
+    if constexpr (Stats::enabled) {
+        size_t head = std::min(pos + 1, dequeuePos_.load(std::memory_order_relaxed));
+        stats_.onPush(1, pos + 1 - head);
+    }
+    return true;
+}
+
+// The cell at the consumer position is ready when its sequence is position + 1; releasing it
+// hands it to the producer one lap ahead
+template <typename T, typename Stats>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::dequeue(T &item) {
+    size_t pos = dequeuePos_.load(std::memory_order_relaxed);
+    Cell *cell;
+    while (true) {
+        cell = &cells_[cellIndex(pos)];
+        size_t seq = cell->sequence.load(std::memory_order_acquire);
+        auto diff = static_cast<intptr_t>(seq) - static_cast<intptr_t>(pos + 1);
+        if (diff == 0) {
+            if (dequeuePos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+        } else if (diff < 0) {
+            return false; // Empty
+        } else {
+            pos = dequeuePos_.load(std::memory_order_relaxed);
+        }
+    }
+    item = std::move(*cell->item());
+    std::destroy_at(cell->item());
+    if constexpr (Stats::enabled) {
+        stats_.onLatency(Stats::now() - cell->stamp);
+        stats_.onPop(1);
+    }
+    cell->sequence.store(pos + max_size_, std::memory_order_release);
+    return true;
+}
+
+template <typename T, typename Stats>
+template <typename U>
+void ThreadSafeQueue<T, LockFreePolicy, Stats>::pushBlocking(U &&item) {
+    uint64_t stamp = Stats::now();
+    uint64_t blockedAt = 0;
+    for (int spin = 0;; ++spin) {
+        if (shutdown_.load(std::memory_order_acquire)) {
+            throw std::runtime_error("Queue is shutting down.");
+        }
+        if (enqueue(std::forward<U>(item), stamp)) break;
+        if (spin == 0) blockedAt = Stats::now();
+        if (spin < SPINS) continue;
+        uint32_t key = notFull_.prepareWait();
+        if (shutdown_.load(std::memory_order_acquire)) {
+            notFull_.cancelWait(key);
+            throw std::runtime_error("Queue is shutting down.");
+        }
+        if (enqueue(std::forward<U>(item), stamp)) {
+            notFull_.cancelWait(key);
+            break;
+        }
+        notFull_.wait(key);
+    }
+    if (blockedAt) stats_.onPushBlocked(Stats::now() - blockedAt);
+    notEmpty_.notify();
+}
+
+template <typename T, typename Stats>
+template <typename U>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::tryPushImpl(U &&item) {
+    if (shutdown_.load(std::memory_order_acquire) ||
+        !enqueue(std::forward<U>(item), Stats::now())) {
+        stats_.onFailedPush();
+        return false;
+    }
+    notEmpty_.notify();
+    return true;
+}
+
+template <typename T, typename Stats>
+void ThreadSafeQueue<T, LockFreePolicy, Stats>::push(const T &item) {
+    pushBlocking(item);
+}
+
+template <typename T, typename Stats>
+void ThreadSafeQueue<T, LockFreePolicy, Stats>::push(T &&item) {
+    pushBlocking(std::move(item));
+}
+
+template <typename T, typename Stats>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::tryPush(const T &item) {
+    return tryPushImpl(item);
+}
+
+template <typename T, typename Stats>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::tryPush(T &&item) {
+    return tryPushImpl(std::move(item));
+}
+
+// Blocks if empty; throws once shut down and drained
+template <typename T, typename Stats> T ThreadSafeQueue<T, LockFreePolicy, Stats>::pop() {
+    T item;
+    uint64_t blockedAt = 0;
+    for (int spin = 0;; ++spin) {
+        if (dequeue(item)) break;
+        if (spin == 0) blockedAt = Stats::now();
+        if (spin < SPINS) continue;
+        uint32_t key = notEmpty_.prepareWait();
+        if (dequeue(item)) {
+            notEmpty_.cancelWait(key);
+            break;
+        }
+        if (shutdown_.load(std::memory_order_acquire)) {
+            notEmpty_.cancelWait(key);
+            // A push may have landed between the failed dequeue and the shutdown check
+            if (dequeue(item)) break;
+            throw std::runtime_error("Queue is shutting down.");
+        }
+        notEmpty_.wait(key);
+    }
+    if (blockedAt) stats_.onPopBlocked(Stats::now() - blockedAt);
+    notFull_.notify();
+    return item;
+}
+
+template <typename T, typename Stats>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::tryPop(T &item) {
+    if (!dequeue(item)) return false;
+    notFull_.notify();
+    return true;
+}
+
+template <typename T, typename Stats>
+size_t ThreadSafeQueue<T, LockFreePolicy, Stats>::size() const {
+    // Dequeue position first, so the enqueue position read after it is never behind
+    size_t head = dequeuePos_.load(std::memory_order_acquire);
+    size_t tail = enqueuePos_.load(std::memory_order_acquire);
+    return std::min(tail - head, max_size_);
+}
+
+template <typename T, typename Stats>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::empty() const {
+    return size() == 0;
+}
+
+template <typename T, typename Stats> void ThreadSafeQueue<T, LockFreePolicy, Stats>::shutdown() {
+    shutdown_.store(true, std::memory_order_release);
+    notEmpty_.notify();
+    notFull_.notify();
+}
+
+template <typename T, typename Stats>
+bool ThreadSafeQueue<T, LockFreePolicy, Stats>::isShutdown() const {
+    return shutdown_.load(std::memory_order_acquire);
+}
+
+template <typename T, typename Stats>
+QueueStatsSnapshot ThreadSafeQueue<T, LockFreePolicy, Stats>::stats() const
+    requires Stats::enabled
+{
+    return stats_.snapshot();
+}
+
+#endif
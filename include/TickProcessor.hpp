@@ -0,0 +1,495 @@
+#ifndef TICKPROCESSOR_HPP
+#define TICKPROCESSOR_HPP
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <deque>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include "CircularBuffer.hpp"
+#include "TickRecord.hpp"
+
+// Unbounded mutex-and-condition-variable queue, the default TickProcessor worker input
+template <typename T> class TickQueue {
+  private:
+    mutable std::mutex mtx_;
+    std::queue<T> queue_;
+    std::condition_variable condition_;
+
+  public:
+    void push(T item) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        queue_.push(item);
+        condition_.notify_one();
+    }
+
+    bool tryPop(T &item) {
+        std::lock_guard<std::mutex> lock(mtx_);
+        if (queue_.empty()) {
+            return false;
+        }
+        item = queue_.front();
+        queue_.pop();
+        return true;
+    }
+
+    template <typename Rep, typename Period>
+    bool waitAndPop(T &item, const std::chrono::duration<Rep, Period> &timeout) {
+        std::unique_lock<std::mutex> lock(mtx_);
+        if (condition_.wait_for(lock, timeout, [this] { return !queue_.empty(); })) {
+            item = queue_.front();
+            queue_.pop();
+            return true;
+        }
+        return false;
+    }
+
+    bool empty() const {
+        std::lock_guard<std::mutex> lock(mtx_);
+        return queue_.empty();
+    }
+};
+
+struct Tick {
+    std::string symbol;
+    double price;
+    int volume;
+
+    Tick() = default;
+    Tick(std::string s, double p, int v) : symbol(s), price(p), volume(v) {}
+    // A record's name is at most 8 bytes, so it fits the string's inline buffer
+    explicit Tick(const TickRecord &record)
+        : symbol(record.symbolName()), price(record.price()), volume(record.volume) {}
+};
+
+struct VWAPData {
+    double vwap = 0.0;
+    double totalValue = 0.0;
+    int totalVolume = 0;
+};
+
+// How a worker drains its queue. Up to batchSize ticks are taken per wake-up and published
+// under one lock; once a batch has its first tick the worker waits at most flushDeadline for
+// the rest, so the deadline caps the latency batching adds. The defaults publish every tick on
+// its own.
+struct BatchConfig {
+    size_t batchSize = 1;
+    std::chrono::microseconds flushDeadline{0};
+};
+
+// One symbol's VWAP as returned by getAllVWAPs
+struct SymbolVWAP {
+    std::string symbol;
+    VWAPData data;
+};
+
+// Ticks are routed by symbol hash to one of numWorkers workers. Each worker has its own queue
+// and owns a disjoint partition of the VWAP data, so all ticks of a symbol are applied in
+// order by one thread and workers never share a lock.
+//
+// Results are published lock-free: every symbol's VWAP sits behind a seqlock, the symbols of a
+// partition are found through an insert-only hash table, and the partition as a whole has a
+// seqlock bumped around each batch. Readers only ever load shared memory.
+//
+// Queue is the per-worker input queue type: TickQueue<Tick> by default, or an SpscQueue
+// from CircularBuffer.hpp when a single thread calls addTick
+template <typename Queue = TickQueue<Tick>> class TickProcessor {
+  private:
+    // A symbol's published VWAP; single writer, the worker that owns the symbol
+    struct alignas(64) PublishedVWAP {
+        PublishedVWAP(const std::string &name, size_t nameHash) : symbol(name), hash(nameHash) {}
+
+        const std::string symbol;
+        const size_t hash;
+        std::atomic<uint64_t> sequence{0};
+        std::atomic<double> vwap{0.0};
+        std::atomic<double> totalValue{0.0};
+        std::atomic<int> totalVolume{0};
+
+        void publish(const VWAPData &data) {
+            uint64_t seq = sequence.load(std::memory_order_relaxed);
+            sequence.store(seq + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            vwap.store(data.vwap, std::memory_order_relaxed);
+            totalValue.store(data.totalValue, std::memory_order_relaxed);
+            totalVolume.store(data.totalVolume, std::memory_order_relaxed);
+            sequence.store(seq + 2, std::memory_order_release);
+        }
+
+        VWAPData read() const {
+            while (true) {
+                uint64_t before = sequence.load(std::memory_order_acquire);
+                if (before & 1) continue;
+                VWAPData data = load();
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (sequence.load(std::memory_order_relaxed) == before) return data;
+            }
+        }
+
+        // Unchecked; only meaningful inside the partition's seqlock
+        VWAPData load() const {
+            return {vwap.load(std::memory_order_relaxed),
+                    totalValue.load(std::memory_order_relaxed),
+                    totalVolume.load(std::memory_order_relaxed)};
+        }
+    };
+
+    // Insert-only open-addressing index of a partition's symbols (Fibonacci hashing, so the
+    // bits that picked the worker do not also pick the slot). Only the worker inserts, and it
+    // copies the table into one twice the size before it gets half full. Replaced tables are
+    // kept until the processor is destroyed since readers may still be probing them.
+    struct SymbolTable {
+        explicit SymbolTable(unsigned bits) : bits(bits), slots(size_t(1) << bits) {}
+
+        unsigned bits;
+        std::vector<std::atomic<const PublishedVWAP *>> slots;
+
+        size_t home(size_t hash) const {
+            return static_cast<size_t>((hash * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+        }
+    };
+
+    // Worker-private state: the symbol's running totals, where it is published (null until
+    // first published) and its entry in pending for the current batch
+    struct SymbolSlot {
+        VWAPData data;
+        PublishedVWAP *published = nullptr;
+        size_t pending = NO_PENDING;
+    };
+    static constexpr size_t NO_PENDING = SIZE_MAX;
+
+    // Per-symbol sums of the batch being built
+    struct PendingUpdate {
+        std::pair<const std::string, SymbolSlot> *symbol;
+        double value;
+        int volume;
+    };
+
+    // Everything a worker touches, kept on its own cache lines
+    struct alignas(64) Worker {
+        Worker() {
+            tables.push_back(std::make_unique<SymbolTable>(4));
+            table.store(tables.back().get(), std::memory_order_relaxed);
+        }
+
+        Queue tickQueue;
+        std::thread thread;
+        std::vector<int> cpus;
+
+        std::unordered_map<std::string, SymbolSlot> slots;
+        std::vector<PendingUpdate> pending;
+        int batchTicks = 0;
+
+        std::deque<PublishedVWAP> published; // Deque keeps them in place
+        std::vector<std::unique_ptr<SymbolTable>> tables;
+        size_t symbolCount = 0;
+
+        // What readers load: the current index and the partition's batch seqlock
+        alignas(64) std::atomic<const SymbolTable *> table{nullptr};
+        std::atomic<uint64_t> sequence{0};
+
+        alignas(64) std::atomic<int> ticksProcessed{0};
+    };
+
+    BatchConfig config_;
+    std::vector<std::unique_ptr<Worker>> workers_;
+    std::atomic<bool> running_{false};
+
+  public:
+    // affinity[i], when given and not empty, is the set of cores worker i may run on; use
+    // numaNodeCpus() to keep a worker on one NUMA node
+    explicit TickProcessor(size_t numWorkers = 1, const BatchConfig &config = BatchConfig(),
+                           std::vector<std::vector<int>> affinity = {})
+        : config_(config) {
+        if (numWorkers == 0) {
+            throw std::invalid_argument("Processor needs at least one worker");
+        }
+        if (config_.batchSize == 0) {
+            throw std::invalid_argument("Batch size must be positive");
+        }
+        for (size_t i = 0; i < numWorkers; ++i) {
+            auto worker = std::make_unique<Worker>();
+            if (i < affinity.size()) worker->cpus = std::move(affinity[i]);
+            workers_.push_back(std::move(worker));
+        }
+    }
+
+    ~TickProcessor() {
+        if (running_.load()) {
+            stop();
+        }
+    }
+
+    TickProcessor(const TickProcessor &) = delete;
+    TickProcessor &operator=(const TickProcessor &) = delete;
+
+    void start() {
+        bool expected = false;
+        if (running_.compare_exchange_strong(expected, true)) {
+            for (auto &worker : workers_) {
+                worker->thread = std::thread(&TickProcessor::processorLoop, this, worker.get());
+            }
+        }
+    }
+
+    void stop() {
+        bool expected = true;
+        if (running_.compare_exchange_strong(expected, false)) {
+            for (auto &worker : workers_) {
+                if (worker->thread.joinable()) {
+                    worker->thread.join();
+                }
+            }
+        }
+    }
+
+    void addTick(const Tick &tick) {
+        if (running_.load()) {
+            workerFor(tick.symbol).tickQueue.push(tick);
+        }
+    }
+
+    void addTick(const TickRecord &tick) {
+        if (running_.load()) {
+            Tick converted(tick);
+            workerFor(converted.symbol).tickQueue.push(std::move(converted));
+        }
+    }
+
+    // Queue a run of records, e.g. a span of a TickFileReader
+    void addTicks(std::span<const TickRecord> ticks) {
+        for (const TickRecord &tick : ticks) {
+            addTick(tick);
+        }
+    }
+
+    double getVWAP(const std::string &symbol) const {
+        return getVWAPData(symbol).vwap;
+    }
+
+    // All of a symbol's totals, read together; zeros for an unknown symbol
+    VWAPData getVWAPData(const std::string &symbol) const {
+        size_t hash = std::hash<std::string>{}(symbol);
+        const PublishedVWAP *entry = find(*workers_[hash % workers_.size()], symbol, hash);
+        return entry ? entry->read() : VWAPData();
+    }
+
+    // Every symbol in one call. Each partition is copied as of a batch boundary, so ticks
+    // published together are seen together; partitions are independent, and are read one
+    // after another.
+    void getAllVWAPs(std::vector<SymbolVWAP> &out) const {
+        out.clear();
+        for (const auto &worker : workers_) {
+            size_t base = out.size();
+            while (true) {
+                uint64_t before = worker->sequence.load(std::memory_order_acquire);
+                if (before & 1) {
+                    cpuRelax();
+                    continue;
+                }
+                out.resize(base);
+                const SymbolTable *table = worker->table.load(std::memory_order_acquire);
+                for (const auto &slot : table->slots) {
+                    const PublishedVWAP *entry = slot.load(std::memory_order_acquire);
+                    if (entry) out.push_back({entry->symbol, entry->load()});
+                }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if (worker->sequence.load(std::memory_order_relaxed) == before) break;
+            }
+        }
+    }
+
+    int getProcessedCount() const {
+        int total = 0;
+        for (const auto &worker : workers_) {
+            total += worker->ticksProcessed.load();
+        }
+        return total;
+    }
+
+    size_t workerCount() const {
+        return workers_.size();
+    }
+
+    // Cores of a NUMA node, from its sysfs cpulist ("0-3,8-11"); empty if unknown
+    static std::vector<int> numaNodeCpus(int node) {
+        std::vector<int> cpus;
+#ifdef __linux__
+        std::ifstream in("/sys/devices/system/node/node" + std::to_string(node) + "/cpulist");
+        std::string range;
+        while (std::getline(in, range, ',')) {
+            int first = 0;
+            int last = 0;
+            int fields = std::sscanf(range.c_str(), "%d-%d", &first, &last);
+            if (fields < 1) continue;
+            if (fields == 1) last = first;
+            for (int cpu = first; cpu <= last; ++cpu) {
+                cpus.push_back(cpu);
+            }
+        }
+#else
+        (void) node;
+#endif
+        return cpus;
+    }
+
+  private:
+    Worker &workerFor(const std::string &symbol) const {
+        return *workers_[std::hash<std::string>{}(symbol) % workers_.size()];
+    }
+
+    static const PublishedVWAP *find(const Worker &worker, const std::string &symbol,
+                                     size_t hash) {
+        const SymbolTable *table = worker.table.load(std::memory_order_acquire);
+        size_t mask = table->slots.size() - 1;
+        for (size_t i = table->home(hash);; i = (i + 1) & mask) {
+            const PublishedVWAP *entry = table->slots[i].load(std::memory_order_acquire);
+            if (!entry) return nullptr;
+            if (entry->hash == hash && entry->symbol == symbol) return entry;
+        }
+    }
+
+    static void insert(SymbolTable &table, const PublishedVWAP *entry) {
+        size_t mask = table.slots.size() - 1;
+        size_t i = table.home(entry->hash);
+        while (table.slots[i].load(std::memory_order_relaxed)) {
+            i = (i + 1) & mask;
+        }
+        table.slots[i].store(entry, std::memory_order_release);
+    }
+
+    // Worker only: give a symbol its published slot, growing the index first if needed
+    static PublishedVWAP *addSymbol(Worker &worker, const std::string &symbol) {
+        size_t hash = std::hash<std::string>{}(symbol);
+        PublishedVWAP &entry = worker.published.emplace_back(symbol, hash);
+        SymbolTable *table = worker.tables.back().get();
+        if ((worker.symbolCount + 1) * 2 > table->slots.size()) {
+            auto grown = std::make_unique<SymbolTable>(table->bits + 1);
+            for (const auto &slot : table->slots) {
+                if (const PublishedVWAP *existing = slot.load(std::memory_order_relaxed)) {
+                    insert(*grown, existing);
+                }
+            }
+            table = grown.get();
+            worker.tables.push_back(std::move(grown));
+            worker.table.store(table, std::memory_order_release);
+        }
+        insert(*table, &entry);
+        worker.symbolCount++;
+        return &entry;
+    }
+
+    static void pinToCpus(const std::vector<int> &cpus) {
+#ifdef __linux__
+        if (cpus.empty()) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int cpu : cpus) {
+            CPU_SET(cpu, &set);
+        }
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void) cpus;
+#endif
+    }
+
+    void processorLoop(Worker *worker) {
+        pinToCpus(worker->cpus);
+        Tick tick;
+        while (running_.load()) {
+            if (!worker->tickQueue.waitAndPop(tick, std::chrono::milliseconds(100))) continue;
+            addToBatch(*worker, tick);
+            fillBatch(*worker, tick);
+            publishBatch(*worker);
+        }
+
+        while (worker->tickQueue.tryPop(tick)) {
+            addToBatch(*worker, tick);
+            if (worker->batchTicks == static_cast<int>(config_.batchSize)) publishBatch(*worker);
+        }
+        publishBatch(*worker);
+    }
+
+    // Take whatever is already queued, then wait for more until the batch is full or the
+    // flush deadline passes
+    void fillBatch(Worker &worker, Tick &tick) {
+        auto deadline = std::chrono::steady_clock::now() + config_.flushDeadline;
+        for (size_t taken = 1; taken < config_.batchSize; ++taken) {
+            if (!worker.tickQueue.tryPop(tick)) {
+                auto now = std::chrono::steady_clock::now();
+                if (now >= deadline || !worker.tickQueue.waitAndPop(tick, deadline - now)) return;
+            }
+            addToBatch(worker, tick);
+        }
+    }
+
+    bool validateTick(const Tick &tick) const {
+        return !tick.symbol.empty() && tick.price > 0.0 && tick.volume > 0;
+    }
+
+    // Fold a tick into its symbol's pending sums; nothing shared is touched
+    void addToBatch(Worker &worker, const Tick &tick) {
+        if (!validateTick(tick)) return;
+        auto it = worker.slots.find(tick.symbol);
+        if (it == worker.slots.end()) it = worker.slots.emplace(tick.symbol, SymbolSlot()).first;
+        SymbolSlot &slot = it->second;
+        if (slot.pending == NO_PENDING) {
+            slot.pending = worker.pending.size();
+            worker.pending.push_back({&*it, 0.0, 0});
+        }
+        PendingUpdate &update = worker.pending[slot.pending];
+        update.value += tick.price * tick.volume;
+        update.volume += tick.volume;
+        worker.batchTicks++;
+    }
+
+    // Publish the batch inside one round of the partition seqlock and count it with one
+    // atomic add
+    void publishBatch(Worker &worker) {
+        if (worker.pending.empty()) return;
+        uint64_t seq = worker.sequence.load(std::memory_order_relaxed);
+        worker.sequence.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (const auto &update : worker.pending) {
+            SymbolSlot &slot = update.symbol->second;
+            slot.pending = NO_PENDING;
+            VWAPData &vwap_data = slot.data;
+
+            vwap_data.totalValue += update.value;
+            vwap_data.totalVolume += update.volume;
+
+            if (vwap_data.totalVolume > 0) {
+                vwap_data.vwap = vwap_data.totalValue / vwap_data.totalVolume;
+            }
+
+            if (!slot.published) slot.published = addSymbol(worker, update.symbol->first);
+            slot.published->publish(vwap_data);
+        }
+        worker.sequence.store(seq + 2, std::memory_order_release);
+        worker.ticksProcessed.fetch_add(worker.batchTicks);
+        worker.pending.clear();
+        worker.batchTicks = 0;
+    }
+};
+
+#endif
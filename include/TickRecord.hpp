@@ -0,0 +1,255 @@
+#ifndef TICKRECORD_HPP
+#define TICKRECORD_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define TICKRECORD_MMAP 1
+#endif
+
+// Fixed-size tick shared by every component and by tick files. Trivially copyable, so batches
+// move with memcpy and a file of records can be used in place once mapped.
+struct TickRecord {
+    // Prices are integers in units of 1 / PRICE_SCALE
+    static constexpr int64_t PRICE_SCALE = 10000;
+
+    uint64_t symbol;     // Up to 8 name bytes, NUL padded (see encodeSymbol)
+    int64_t priceTicks;  // Price * PRICE_SCALE
+    int64_t timestampNs; // Nanoseconds since epoch
+    int32_t volume;
+    uint32_t reserved; // Zero; keeps the record at 32 bytes with no implicit padding
+
+    // Symbol name as a code whose bytes in memory are the name's bytes, so codes compare and
+    // hash as integers and decode without a table. Names longer than 8 bytes are rejected.
+    static constexpr uint64_t encodeSymbol(std::string_view name) {
+        if (name.empty() || name.size() > 8) {
+            throw std::invalid_argument("Symbol must be 1 to 8 bytes");
+        }
+        std::array<char, 8> bytes{};
+        for (size_t i = 0; i < name.size(); ++i) {
+            bytes[i] = name[i];
+        }
+        return std::bit_cast<uint64_t>(bytes);
+    }
+
+    static int64_t toTicks(double price) {
+        return std::llround(price * static_cast<double>(PRICE_SCALE));
+    }
+
+    static TickRecord make(std::string_view name, double price, int32_t volume,
+                           int64_t timestampNs) {
+        return {encodeSymbol(name), toTicks(price), timestampNs, volume, 0};
+    }
+
+    double price() const {
+        return static_cast<double>(priceTicks) / static_cast<double>(PRICE_SCALE);
+    }
+
+    long long timestampMs() const {
+        return timestampNs / 1000000;
+    }
+
+    // Points into the record, so only valid while it is
+    std::string_view symbolName() const {
+        const char *bytes = reinterpret_cast<const char *>(&symbol);
+        size_t length = 0;
+        while (length < 8 && bytes[length] != '\0') {
+            length++;
+        }
+        return {bytes, length};
+    }
+};
+
+static_assert(sizeof(TickRecord) == 32, "TickRecord must stay 32 bytes");
+static_assert(std::is_trivially_copyable_v<TickRecord> && std::is_standard_layout_v<TickRecord>);
+
+// Tick file layout (native byte order): a 32-byte TickFileHeader followed by count records.
+// The header is one record wide, so records stay 32-byte aligned in a page-aligned mapping.
+struct TickFileHeader {
+    static constexpr char MAGIC[8] = {'T', 'I', 'C', 'K', 'R', 'E', 'C', '\0'};
+    static constexpr uint32_t VERSION = 1;
+
+    char magic[8];
+    uint32_t version;
+    uint32_t recordSize;
+    uint64_t count;
+    uint64_t reserved;
+};
+
+static_assert(sizeof(TickFileHeader) == sizeof(TickRecord), "Header must be one record wide");
+
+// Appends records to a tick file. The header's count is written when the file is closed, so a
+// file that was never closed is rejected by TickFileReader instead of read short.
+class TickFileWriter {
+  public:
+    explicit TickFileWriter(const std::string &path) : path_(path), file_(nullptr), count_(0) {
+        file_ = std::fopen(path.c_str(), "wb");
+        if (!file_) throw std::runtime_error("Cannot write " + path);
+        writeHeader(UINT64_MAX);
+    }
+
+    ~TickFileWriter() {
+        if (file_) {
+            writeHeader(count_);
+            std::fclose(file_);
+        }
+    }
+
+    TickFileWriter(const TickFileWriter &) = delete;
+    TickFileWriter &operator=(const TickFileWriter &) = delete;
+
+    void write(const TickRecord &record) {
+        write(std::span<const TickRecord>(&record, 1));
+    }
+
+    void write(std::span<const TickRecord> records) {
+        if (!file_) throw std::logic_error("Tick file is closed");
+        if (std::fwrite(records.data(), sizeof(TickRecord), records.size(), file_) !=
+            records.size()) {
+            throw std::runtime_error("Short write to " + path_);
+        }
+        count_ += records.size();
+    }
+
+    // Finish the header and flush; further writes throw
+    void close() {
+        if (!file_) return;
+        writeHeader(count_);
+        bool flushed = std::fclose(file_) == 0;
+        file_ = nullptr;
+        if (!flushed) throw std::runtime_error("Cannot flush " + path_);
+    }
+
+    uint64_t count() const {
+        return count_;
+    }
+
+  private:
+    std::string path_;
+    std::FILE *file_;
+    uint64_t count_;
+
+    void writeHeader(uint64_t count) {
+        TickFileHeader header{};
+        std::memcpy(header.magic, TickFileHeader::MAGIC, sizeof(header.magic));
+        header.version = TickFileHeader::VERSION;
+        header.recordSize = sizeof(TickRecord);
+        header.count = count;
+        long position = std::ftell(file_);
+        std::fseek(file_, 0, SEEK_SET);
+        std::fwrite(&header, sizeof(header), 1, file_);
+        if (position > 0) std::fseek(file_, position, SEEK_SET);
+    }
+};
+
+// Read-only view of a tick file. On POSIX the file is memory-mapped and records() points
+// straight into the mapping, so replay touches each record once with no parsing or copies;
+// elsewhere the records are read into memory up front.
+class TickFileReader {
+  public:
+    explicit TickFileReader(const std::string &path) : data_(nullptr), size_(0), count_(0) {
+#ifdef TICKRECORD_MMAP
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) throw std::runtime_error("Cannot read " + path);
+        struct stat info;
+        if (::fstat(fd, &info) != 0) {
+            ::close(fd);
+            throw std::runtime_error("Cannot stat " + path);
+        }
+        size_ = static_cast<size_t>(info.st_size);
+        void *mapped = size_ ? ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0) : MAP_FAILED;
+        ::close(fd);
+        if (mapped == MAP_FAILED) throw std::runtime_error("Cannot map " + path);
+        data_ = static_cast<const unsigned char *>(mapped);
+        // Replay reads front to back: let the kernel read ahead aggressively
+        ::madvise(mapped, size_, MADV_SEQUENTIAL);
+#else
+        std::FILE *file = std::fopen(path.c_str(), "rb");
+        if (!file) throw std::runtime_error("Cannot read " + path);
+        unsigned char chunk[65536];
+        size_t n;
+        while ((n = std::fread(chunk, 1, sizeof(chunk), file)) > 0) {
+            buffer_.insert(buffer_.end(), chunk, chunk + n);
+        }
+        std::fclose(file);
+        data_ = buffer_.data();
+        size_ = buffer_.size();
+#endif
+        try {
+            validate(path);
+        } catch (...) {
+            unmap();
+            throw;
+        }
+    }
+
+    ~TickFileReader() {
+        unmap();
+    }
+
+    TickFileReader(const TickFileReader &) = delete;
+    TickFileReader &operator=(const TickFileReader &) = delete;
+
+    // Every record in the file, valid for the reader's lifetime
+    std::span<const TickRecord> records() const {
+        return {reinterpret_cast<const TickRecord *>(data_ + sizeof(TickFileHeader)), count_};
+    }
+
+    // Records [offset, offset + count), clamped to the file
+    std::span<const TickRecord> records(size_t offset, size_t count) const {
+        if (offset >= count_) return {};
+        return records().subspan(offset, std::min(count, count_ - offset));
+    }
+
+    size_t size() const {
+        return count_;
+    }
+
+  private:
+    const unsigned char *data_;
+    size_t size_;
+    size_t count_;
+#ifndef TICKRECORD_MMAP
+    std::vector<unsigned char> buffer_;
+#endif
+
+    void validate(const std::string &path) {
+        TickFileHeader header;
+        if (size_ < sizeof(header)) throw std::runtime_error("Truncated tick file " + path);
+        std::memcpy(&header, data_, sizeof(header));
+        if (std::memcmp(header.magic, TickFileHeader::MAGIC, sizeof(header.magic)) != 0 ||
+            header.version != TickFileHeader::VERSION || header.recordSize != sizeof(TickRecord)) {
+            throw std::runtime_error("Not a tick file: " + path);
+        }
+        if (header.count > (size_ - sizeof(header)) / sizeof(TickRecord)) {
+            throw std::runtime_error("Truncated tick file " + path);
+        }
+        count_ = static_cast<size_t>(header.count);
+    }
+
+    void unmap() {
+#ifdef TICKRECORD_MMAP
+        if (data_) ::munmap(const_cast<unsigned char *>(data_), size_);
+#endif
+        data_ = nullptr;
+    }
+};
+
+#endif
@@ -0,0 +1,505 @@
+#ifndef VWAPCALCULATOR_HPP
+#define VWAPCALCULATOR_HPP
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "TickRecord.hpp"
+
+// Column kernels for batch ingestion, picked at compile time (AVX2, AArch64 NEON or scalar)
+namespace kernels {
+// Sum of prices[i] * volumes[i]
+inline double dotPriceVolume(const double *prices, const int *volumes, size_t n) {
+    size_t i = 0;
+    double sum = 0.0;
+#if defined(__AVX2__)
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8) {
+        const __m128i *v = reinterpret_cast<const __m128i *>(volumes + i);
+        __m256d v0 = _mm256_cvtepi32_pd(_mm_loadu_si128(v));
+        __m256d v1 = _mm256_cvtepi32_pd(_mm_loadu_si128(v + 1));
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(prices + i), v0));
+        acc1 = _mm256_add_pd(acc1, _mm256_mul_pd(_mm256_loadu_pd(prices + i + 4), v1));
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float64x2_t acc = vdupq_n_f64(0.0);
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vcvtq_f64_s64(vmovl_s32(vld1_s32(volumes + i)));
+        acc = vfmaq_f64(acc, vld1q_f64(prices + i), v);
+    }
+    sum = vaddvq_f64(acc);
+#endif
+    for (; i < n; ++i) {
+        sum += prices[i] * volumes[i];
+    }
+    return sum;
+}
+
+// Plain loops the compiler vectorizes on its own
+inline long long sumVolume(const int *volumes, size_t n) {
+    long long sum = 0;
+    for (size_t i = 0; i < n; ++i) {
+        sum += volumes[i];
+    }
+    return sum;
+}
+
+inline int minVolume(const int *volumes, size_t n) {
+    int smallest = INT32_MAX;
+    for (size_t i = 0; i < n; ++i) {
+        smallest = std::min(smallest, volumes[i]);
+    }
+    return smallest;
+}
+
+// In-place inclusive prefix sum of x, starting from carry
+inline void prefixSum(double *x, size_t n, double carry) {
+    size_t i = 0;
+#if defined(__AVX2__)
+    __m256d total = _mm256_set1_pd(carry);
+    __m256d zero = _mm256_setzero_pd();
+    for (; i + 4 <= n; i += 4) {
+        // Log-step scan within the vector: shift by one lane and add, then by two
+        __m256d v = _mm256_loadu_pd(x + i);
+        __m256d shifted = _mm256_blend_pd(_mm256_permute4x64_pd(v, 0x93), zero, 0x1);
+        v = _mm256_add_pd(v, shifted);
+        shifted = _mm256_blend_pd(_mm256_permute4x64_pd(v, 0x4E), zero, 0x3);
+        v = _mm256_add_pd(_mm256_add_pd(v, shifted), total);
+        _mm256_storeu_pd(x + i, v);
+        total = _mm256_permute4x64_pd(v, 0xFF);
+    }
+    carry = n >= 4 ? x[i - 1] : carry;
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+    float64x2_t total = vdupq_n_f64(carry);
+    float64x2_t zero = vdupq_n_f64(0.0);
+    for (; i + 2 <= n; i += 2) {
+        float64x2_t v = vld1q_f64(x + i);
+        v = vaddq_f64(vaddq_f64(v, vextq_f64(zero, v, 1)), total);
+        vst1q_f64(x + i, v);
+        total = vdupq_laneq_f64(v, 1);
+    }
+    carry = n >= 2 ? x[i - 1] : carry;
+#endif
+    for (; i < n; ++i) {
+        carry += x[i];
+        x[i] = carry;
+    }
+}
+} // namespace kernels
+
+// One slot of a VWAP window ring
+struct PriceVolume {
+    double price;
+    int volume;
+
+    PriceVolume() : price(0.0), volume(0) {}
+    PriceVolume(double p, int v) : price(p), volume(v) {}
+};
+
+// Window size chosen at runtime, like std::dynamic_extent
+inline constexpr size_t dynamicWindow = SIZE_MAX;
+
+// VWAP over the last windowSize ticks. The ticks live in a power-of-two ring that is zero-filled
+// up front, so the tick leaving the window is always read from the ring (a zero tick while the
+// window fills) and addTick neither branches on the fill level nor allocates. N fixes the window
+// at compile time and stores the ring inline; the default sizes it at construction.
+template <size_t N = dynamicWindow> class VWAPCalculator {
+  private:
+    static_assert(N > 0, "Window size must be positive");
+
+    static constexpr size_t STATIC_RING = N == dynamicWindow ? 1 : std::bit_ceil(N);
+    // Totals are rebuilt from the ring this often (in ring laps) so rounding error cannot
+    // accumulate over billions of add/evict cycles
+    static constexpr uint64_t RECOMPUTE_LAPS = 16;
+    // Ticks per stack-buffered step of the per-tick VWAP batch path
+    static constexpr size_t BATCH_CHUNK = 256;
+
+    using Ring = std::conditional_t<N == dynamicWindow, std::vector<PriceVolume>,
+                                    std::array<PriceVolume, STATIC_RING>>;
+
+    Ring ticks;
+    size_t windowSize;
+    uint64_t mask;
+    uint64_t added;
+    double totalPriceVolume;
+    long long totalVolume;
+
+    size_t window() const {
+        if constexpr (N == dynamicWindow) {
+            return windowSize;
+        } else {
+            return N;
+        }
+    }
+
+    void recompute() {
+        totalPriceVolume = 0.0;
+        totalVolume = 0;
+        for (const PriceVolume &tick : ticks) {
+            totalPriceVolume += tick.price * tick.volume;
+            totalVolume += tick.volume;
+        }
+    }
+
+    static void validateBatch(std::span<const double> prices, std::span<const int> volumes) {
+        if (prices.size() != volumes.size()) {
+            throw std::invalid_argument("Price and volume columns must have the same length");
+        }
+        if (kernels::minVolume(volumes.data(), volumes.size()) <= 0) {
+            throw std::invalid_argument("Volume must be positive");
+        }
+    }
+
+    // Account for n ticks written to the ring by a batch
+    void finishBatch(size_t n) {
+        uint64_t interval = RECOMPUTE_LAPS * (mask + 1);
+        bool wrapped = added / interval != (added + n) / interval;
+        added += n;
+        if (wrapped) recompute();
+    }
+
+  public:
+    VWAPCalculator(int windowSize = 100)
+        requires(N == dynamicWindow)
+        : windowSize(static_cast<size_t>(windowSize)), added(0), totalPriceVolume(0.0),
+          totalVolume(0) {
+        if (windowSize <= 0) {
+            throw std::invalid_argument("Window size must be positive");
+        }
+        ticks.assign(std::bit_ceil(this->windowSize), PriceVolume());
+        mask = ticks.size() - 1;
+    }
+
+    VWAPCalculator()
+        requires(N != dynamicWindow)
+        : ticks(), windowSize(N), mask(STATIC_RING - 1), added(0), totalPriceVolume(0.0),
+          totalVolume(0) {}
+
+    // Add a tick
+    void addTick(double price, int volume) {
+        if (volume <= 0) {
+            throw std::invalid_argument("Volume must be positive");
+        }
+
+        // Zeroing the evicted slot leaves only the window in the ring, for recompute()
+        PriceVolume &slot = ticks[(added - window()) & mask];
+        PriceVolume victim = slot;
+        slot = PriceVolume();
+        totalPriceVolume -= victim.price * victim.volume;
+        totalVolume -= victim.volume;
+
+        ticks[added & mask] = PriceVolume(price, volume);
+        totalPriceVolume += price * volume;
+        totalVolume += volume;
+        added++;
+
+        if ((added & (RECOMPUTE_LAPS * (mask + 1) - 1)) == 0) recompute();
+    }
+
+    // Add a batch of ticks given as price and volume columns. The whole batch is validated
+    // before anything is added, so a bad tick leaves the calculator unchanged.
+    void addTicks(std::span<const double> prices, std::span<const int> volumes) {
+        validateBatch(prices, volumes);
+        size_t n = prices.size();
+        size_t w = window();
+
+        if (n >= w) {
+            // Only the last w ticks of the batch survive: rebuild the window from them
+            size_t first = n - w;
+            std::fill(ticks.begin(), ticks.end(), PriceVolume());
+            for (size_t i = first; i < n; ++i) {
+                ticks[(added + i) & mask] = PriceVolume(prices[i], volumes[i]);
+            }
+            totalPriceVolume =
+                kernels::dotPriceVolume(prices.data() + first, volumes.data() + first, w);
+            totalVolume = kernels::sumVolume(volumes.data() + first, w);
+        } else {
+            // Every tick the batch evicts predates it, so they are all in the ring
+            double evictedPriceVolume = 0.0;
+            long long evictedVolume = 0;
+            for (size_t i = 0; i < n; ++i) {
+                PriceVolume &slot = ticks[(added + i - w) & mask];
+                evictedPriceVolume += slot.price * slot.volume;
+                evictedVolume += slot.volume;
+                slot = PriceVolume();
+            }
+            for (size_t i = 0; i < n; ++i) {
+                ticks[(added + i) & mask] = PriceVolume(prices[i], volumes[i]);
+            }
+            totalPriceVolume += kernels::dotPriceVolume(prices.data(), volumes.data(), n) -
+                                evictedPriceVolume;
+            totalVolume += kernels::sumVolume(volumes.data(), n) - evictedVolume;
+        }
+        finishBatch(n);
+    }
+
+    void addTick(const TickRecord &tick) {
+        addTick(tick.price(), tick.volume);
+    }
+
+    // Add a batch of records, e.g. a span straight out of a TickFileReader. Records are
+    // unpacked into price and volume columns a chunk at a time; as with the column overload,
+    // a bad tick anywhere in the batch leaves the calculator unchanged.
+    void addTicks(std::span<const TickRecord> records) {
+        for (const TickRecord &tick : records) {
+            if (tick.volume <= 0) throw std::invalid_argument("Volume must be positive");
+        }
+        double prices[BATCH_CHUNK];
+        int volumes[BATCH_CHUNK];
+        size_t n = records.size();
+        for (size_t c = 0; c < n; c += BATCH_CHUNK) {
+            size_t len = std::min(BATCH_CHUNK, n - c);
+            for (size_t j = 0; j < len; ++j) {
+                prices[j] = records[c + j].price();
+                volumes[j] = records[c + j].volume;
+            }
+            addTicks(std::span<const double>(prices, len), std::span<const int>(volumes, len));
+        }
+    }
+
+    // addTicks() that also writes the VWAP after each tick to vwaps (same length as the batch).
+    // Per-tick changes to the totals are prefix-summed, so results can differ from addTick()
+    // calls in the last bits.
+    void addTicks(std::span<const double> prices, std::span<const int> volumes,
+                  std::span<double> vwaps) {
+        validateBatch(prices, volumes);
+        if (vwaps.size() != prices.size()) {
+            throw std::invalid_argument("VWAP output must have the same length as the batch");
+        }
+        size_t n = prices.size();
+        size_t w = window();
+        uint64_t start = added;
+        double priceVolumeDelta[BATCH_CHUNK];
+        double volumeDelta[BATCH_CHUNK];
+
+        for (size_t c = 0; c < n; c += BATCH_CHUNK) {
+            size_t len = std::min(BATCH_CHUNK, n - c);
+            long long chunkVolume = 0;
+            for (size_t j = 0; j < len; ++j) {
+                size_t i = c + j;
+                // The tick leaving the window is in the ring only if it predates the batch
+                PriceVolume evicted = i >= w ? PriceVolume(prices[i - w], volumes[i - w])
+                                      : ticks[(start + i - w) & mask];
+                priceVolumeDelta[j] = prices[i] * volumes[i] - evicted.price * evicted.volume;
+                volumeDelta[j] = volumes[i] - evicted.volume;
+                chunkVolume += volumes[i] - evicted.volume;
+            }
+            kernels::prefixSum(priceVolumeDelta, len, totalPriceVolume);
+            kernels::prefixSum(volumeDelta, len, static_cast<double>(totalVolume));
+            for (size_t j = 0; j < len; ++j) {
+                vwaps[c + j] = priceVolumeDelta[j] / volumeDelta[j];
+            }
+
+            for (size_t j = 0; j < len; ++j) {
+                uint64_t i = start + c + j;
+                ticks[(i - w) & mask] = PriceVolume();
+                ticks[i & mask] = PriceVolume(prices[c + j], volumes[c + j]);
+            }
+            totalPriceVolume = priceVolumeDelta[len - 1];
+            totalVolume += chunkVolume;
+        }
+        finishBatch(n);
+    }
+
+    // Calculate current VWAP
+    double getVWAP() const {
+        if (totalVolume == 0) return 0.;
+        return totalPriceVolume / totalVolume;
+    }
+
+    // Number of ticks in window
+    int getTickCount() const {
+        return static_cast<int>(added < window() ? added : window());
+    }
+
+    long long getTotalVolume() const {
+        return totalVolume;
+    }
+
+    double getTotalPriceVolume() const {
+        return totalPriceVolume;
+    }
+
+    void clear() {
+        std::fill(ticks.begin(), ticks.end(), PriceVolume());
+        added = 0;
+        totalPriceVolume = 0.;
+        totalVolume = 0;
+    }
+};
+
+// VWAP over several trailing time horizons at once. Ticks are folded into fixed-width time
+// buckets of (sum price * volume, sum volume) kept in one ring, and every horizon keeps running
+// totals over its own span of buckets. A tick costs O(horizons), a query O(1), however many ticks
+// fall in the window. Horizons are rounded up to whole buckets and end at the newest bucket seen,
+// so the oldest bucket of a horizon may be partly outside it.
+class TimeWindowVWAP {
+  private:
+    struct Bucket {
+        double priceVolume = 0.0;
+        long long volume = 0;
+    };
+
+    struct Horizon {
+        long long ms;
+        long long buckets;
+        double priceVolume = 0.0;
+        long long volume = 0;
+    };
+
+    std::vector<Bucket> buckets;
+    std::vector<Horizon> horizons;
+    long long bucketWidthMs;
+    long long longestHorizon; // In buckets
+    uint64_t mask;
+    long long current; // Number of the newest bucket
+    bool started;
+
+    Bucket &bucketAt(long long number) {
+        return buckets[static_cast<uint64_t>(number) & mask];
+    }
+
+    // Exact totals from the ring, so subtraction rounding never builds up
+    void recompute() {
+        for (auto &horizon : horizons) {
+            horizon.priceVolume = 0.0;
+            horizon.volume = 0;
+            for (long long b = current - horizon.buckets + 1; b <= current; ++b) {
+                horizon.priceVolume += bucketAt(b).priceVolume;
+                horizon.volume += bucketAt(b).volume;
+            }
+        }
+    }
+
+    // Slide every horizon forward so it ends at bucket target
+    void advance(long long target) {
+        if (!started) {
+            current = target;
+            started = true;
+            return;
+        }
+        if (target <= current) return;
+        if (target - current >= static_cast<long long>(buckets.size())) {
+            // Gap longer than the ring: everything has expired
+            std::fill(buckets.begin(), buckets.end(), Bucket());
+            for (auto &horizon : horizons) {
+                horizon.priceVolume = 0.0;
+                horizon.volume = 0;
+            }
+            current = target;
+            return;
+        }
+        while (current < target) {
+            current++;
+            for (auto &horizon : horizons) {
+                const Bucket &leaving = bucketAt(current - horizon.buckets);
+                horizon.priceVolume -= leaving.priceVolume;
+                horizon.volume -= leaving.volume;
+            }
+            // The ring is longer than any horizon, so this bucket has left all of them
+            bucketAt(current) = Bucket();
+            if ((static_cast<uint64_t>(current) & mask) == 0) recompute();
+        }
+    }
+
+  public:
+    TimeWindowVWAP(long long bucketWidthMs, const std::vector<long long> &horizonsMs)
+        : bucketWidthMs(bucketWidthMs), longestHorizon(0), current(0), started(false) {
+        if (bucketWidthMs <= 0) {
+            throw std::invalid_argument("Bucket width must be positive");
+        }
+        if (horizonsMs.empty()) {
+            throw std::invalid_argument("At least one horizon is required");
+        }
+        for (long long ms : horizonsMs) {
+            if (ms <= 0) {
+                throw std::invalid_argument("Horizons must be positive");
+            }
+            Horizon horizon;
+            horizon.ms = ms;
+            horizon.buckets = (ms + bucketWidthMs - 1) / bucketWidthMs;
+            longestHorizon = std::max(longestHorizon, horizon.buckets);
+            horizons.push_back(horizon);
+        }
+        buckets.assign(std::bit_ceil(static_cast<uint64_t>(longestHorizon) + 1), Bucket());
+        mask = buckets.size() - 1;
+    }
+
+    // Timestamps are milliseconds since epoch. A late tick still counts towards the horizons
+    // that cover its bucket; one older than every horizon is dropped.
+    void addTick(long long timestamp, double price, int volume) {
+        if (volume <= 0) {
+            throw std::invalid_argument("Volume must be positive");
+        }
+        long long number = timestamp / bucketWidthMs;
+        advance(number);
+
+        long long age = current - number;
+        if (age >= longestHorizon) return;
+        Bucket &bucket = bucketAt(number);
+        bucket.priceVolume += price * volume;
+        bucket.volume += volume;
+        for (auto &horizon : horizons) {
+            if (age < horizon.buckets) {
+                horizon.priceVolume += price * volume;
+                horizon.volume += volume;
+            }
+        }
+    }
+
+    void addTick(const TickRecord &tick) {
+        addTick(tick.timestampMs(), tick.price(), tick.volume);
+    }
+
+    // Expire buckets up to timestamp without adding a tick, e.g. before querying a quiet symbol
+    void advanceTo(long long timestamp) {
+        advance(timestamp / bucketWidthMs);
+    }
+
+    // Horizons are indexed in the order they were given to the constructor
+    double getVWAP(size_t horizon) const {
+        const Horizon &h = horizons.at(horizon);
+        if (h.volume == 0) return 0.;
+        return h.priceVolume / h.volume;
+    }
+
+    long long getTotalVolume(size_t horizon) const {
+        return horizons.at(horizon).volume;
+    }
+
+    long long getHorizonMs(size_t horizon) const {
+        return horizons.at(horizon).ms;
+    }
+
+    size_t getHorizonCount() const {
+        return horizons.size();
+    }
+
+    void clear() {
+        std::fill(buckets.begin(), buckets.end(), Bucket());
+        for (auto &horizon : horizons) {
+            horizon.priceVolume = 0.0;
+            horizon.volume = 0;
+        }
+        started = false;
+    }
+};
+
+#endif
@@ -0,0 +1,87 @@
+#include <chrono>
+#include <iostream>
+#include <thread>
+
+#include "../include/CircularBuffer.hpp"
+
+// Producer/consumer throughput for one wait policy
+template <typename WaitPolicy> double queueThroughput(int items) {
+    SpscQueue<int, 1024, WaitPolicy> queue;
+    auto start = std::chrono::high_resolution_clock::now();
+    std::thread consumer([&queue, items]() {
+        int value;
+        for (int received = 0; received < items;) {
+            if (queue.waitAndPop(value, std::chrono::milliseconds(100))) received++;
+        }
+    });
+    for (int i = 0; i < items; ++i) {
+        queue.push(i);
+    }
+    consumer.join();
+    auto end = std::chrono::high_resolution_clock::now();
+    return items / std::chrono::duration<double>(end - start).count();
+}
+
+// Example usage and testing
+int main() {
+    std::cout << "=== Circular Buffer Demo ===" << std::endl;
+
+    // Test 1: Fill, overflow and drain
+    {
+        std::cout << "\n--- Test 1: Basic operations ---" << std::endl;
+        CircularBuffer<int, 4> buffer;
+        std::cout << "Empty at start: " << buffer.empty() << std::endl;
+        for (int i = 1; i <= 5; ++i) {
+            bool written = buffer.write(i);
+            std::cout << "write(" << i << "): " << (written ? "ok" : "full") << std::endl;
+        }
+        std::cout << "Full: " << buffer.full() << ", size: " << buffer.size() << std::endl;
+        int value;
+        while (buffer.read(value)) {
+            std::cout << "read: " << value << std::endl;
+        }
+        std::cout << "Empty after drain: " << buffer.empty() << std::endl;
+    }
+
+    // Test 2: Items arrive in order across threads
+    {
+        std::cout << "\n--- Test 2: Ordering across threads ---" << std::endl;
+        const int items = 1000000;
+        CircularBuffer<int, 1024> buffer;
+        bool ordered = true;
+        std::thread consumer([&buffer, &ordered]() {
+            int value;
+            for (int expected = 0; expected < items;) {
+                if (buffer.read(value)) {
+                    ordered &= value == expected;
+                    expected++;
+                } else {
+                    std::this_thread::yield();
+                }
+            }
+        });
+        for (int i = 0; i < items; ++i) {
+            while (!buffer.write(i)) {
+                std::this_thread::yield();
+            }
+        }
+        consumer.join();
+        std::cout << items << " items received in order: " << ordered << std::endl;
+    }
+
+    // Test 3: Throughput per wait policy
+    {
+        std::cout << "\n--- Test 3: Throughput ---" << std::endl;
+        const int items = 2000000;
+        std::cout << "SpinYield: " << queueThroughput<SpinYield>(items) << " items/s" << std::endl;
+        std::cout << "SpinPark:  " << queueThroughput<SpinPark>(items) << " items/s" << std::endl;
+        // BusySpin only makes sense with a core per thread
+        if (std::thread::hardware_concurrency() > 1) {
+            std::cout << "BusySpin:  " << queueThroughput<BusySpin>(items) << " items/s"
+                      << std::endl;
+        }
+    }
+
+    std::cout << "\nAll tests completed!" << std::endl;
+    return 0;
+}
@@ -1,107 +1,28 @@
-#include <cstddef>
+#include <chrono>
 #include <iostream>
-#include <optional>
 #include <string>
-#include <unordered_map>
-
-template <typename Key, typename Value> class LRUCache {
-  private:
-    struct Node {
-        Key key;
-        Value value;
-        Node *prev;
-        Node *next;
-        Node(const Key &k, const Value &v) : key(k), value(v), prev(nullptr), next(nullptr) {}
-    };
-
-    Node *head_;
-    Node *tail_;
-    std::unordered_map<Key, Node *> map_;
-    size_t capacity_;
-
-    void detach(Node *n) {
-        if (!n) return;
-        if (n->prev)
-            n->prev->next = n->next;
-        else
-            head_ = n->next;
-        if (n->next)
-            n->next->prev = n->prev;
-        else
-            tail_ = n->prev;
-        n->prev = nullptr;
-        n->next = nullptr;
-    }
-
-    void push_front(Node *n) {
-        if (!n) return;
-        n->prev = nullptr;
-        n->next = head_;
-        if (head_) head_->prev = n;
-        head_ = n;
-        if (!tail_) tail_ = n;
-    }
-
-  public:
-    explicit LRUCache(size_t capacity) : head_(nullptr), tail_(nullptr), capacity_(capacity) {}
-
-    std::optional<Value> get(const Key &key) {
-        auto it = map_.find(key);
-        if (it == map_.end()) return std::nullopt;
-        Node *n = it->second;
-        detach(n);
-        push_front(n);
-        return n->value;
-    }
-
-    void put(const Key &key, const Value &value) {
-        if (capacity_ == 0) return;
-        auto it = map_.find(key);
-        if (it == map_.end()) {
-            Node *n = new Node(key, value);
-            push_front(n);
-            map_[key] = n;
-            if (size() > capacity_) {
-                Node *victim = tail_;
-                map_.erase(victim->key);
-                detach(victim);
-                delete victim;
+#include <thread>
+#include <vector>
+
+#include "../include/LRUCache.hpp"
+
+// Hit-path throughput of a concurrent cache with a fully resident key set
+template <typename Cache> double readThroughput(Cache &cache, int threads, int keys, int reads) {
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> readers;
+    for (int t = 0; t < threads; ++t) {
+        readers.emplace_back([&cache, t, keys, reads]() {
+            for (int i = 0; i < reads; ++i) {
+                cache.get((i * 7 + t) % keys);
             }
-        } else {
-            Node *n = it->second;
-            detach(n);
-            push_front(n);
-            n->value = value;
-        }
+        });
     }
-
-    bool contains(const Key &key) const {
-        return map_.find(key) != map_.end();
+    for (auto &reader : readers) {
+        reader.join();
     }
-
-    size_t size() const {
-        return map_.size();
-    }
-
-    void clear() {
-        Node *cur = head_;
-        while (cur) {
-            Node *nxt = cur->next;
-            delete cur;
-            cur = nxt;
-        }
-        map_.clear();
-        head_ = nullptr;
-        tail_ = nullptr;
-    }
-
-    ~LRUCache() {
-        clear();
-    }
-
-    LRUCache(const LRUCache &) = delete;
-    LRUCache &operator=(const LRUCache &) = delete;
-};
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(threads) * reads / elapsed.count();
+}
 
 int main() {
     std::cout << "=== LRUCache Tests ===\n";
@@ -138,6 +59,116 @@ int main() {
     std::cout << "Capacity-1 cache contains 10: " << small_cache.contains(10) << std::endl;
     std::cout << "Capacity-1 cache contains 20: " << small_cache.contains(20) << std::endl;
 
+    // Test 5: Flat storage behaves the same way
+    FlatLRUCache<int, std::string> flat(3);
+    flat.put(1, "one");
+    flat.put(2, "two");
+    flat.put(3, "three");
+    flat.get(1);
+    flat.put(4, "four"); // Should evict key 2, reusing its node
+    std::cout << "Flat cache after adding key 4:\n";
+    std::cout << "  Key 1 exists: " << flat.contains(1) << std::endl;
+    std::cout << "  Key 2 exists: " << flat.contains(2) << std::endl;
+    std::cout << "  Key 4 exists: " << flat.contains(4) << std::endl;
+    std::cout << "  Size: " << flat.size() << " / " << flat.capacity() << std::endl;
+
+    // Test 6: Zero-copy access, emplace and heterogeneous lookup
+    LRUCache<std::string, std::string, TransparentStringHash, std::equal_to<>> snapshots(2);
+    snapshots.put(std::string("AAPL"), std::string(4096, 'a'));
+    std::string_view probe = "AAPL";
+    if (const std::string *snapshot = snapshots.getPtr(probe)) {
+        std::cout << "AAPL snapshot bytes (no copy): " << snapshot->size() << std::endl;
+    }
+    auto [msft, inserted] = snapshots.try_emplace(std::string_view("MSFT"), 2048, 'm');
+    std::cout << "try_emplace MSFT inserted: " << inserted << ", bytes: " << msft->size()
+              << std::endl;
+    int loads = 0;
+    auto loader = [&loads]() {
+        loads++;
+        return std::string(1024, 'g');
+    };
+    snapshots.get_or_compute("GOOGL", loader); // Evicts AAPL
+    snapshots.get_or_compute("GOOGL", loader);
+    std::cout << "GOOGL loaded " << loads << " time(s), AAPL exists: "
+              << snapshots.contains(probe) << std::endl;
+    snapshots.visit("MSFT", [](std::string &value) { value.resize(16); });
+    std::cout << "MSFT bytes after visit: " << snapshots.getPtr("MSFT")->size() << std::endl;
+
+    // Test 7: Byte budget
+    auto bytes = [](const std::string &key, const std::string &value) {
+        return key.size() + value.size();
+    };
+    LRUCache<std::string, std::string, std::hash<std::string>, std::equal_to<std::string>,
+             LruPolicy, decltype(bytes)>
+        budget(10000, bytes);
+    budget.put("small", std::string(100, 's'));
+    budget.put("large", std::string(6000, 'l'));
+    budget.put("huge", std::string(20000, 'h')); // Heavier than the whole cache: not kept
+    budget.put("medium", std::string(5000, 'm')); // Evicts "small", then "large"
+    std::cout << "Byte budget: " << budget.size() << " entries, " << budget.weight() << " / "
+              << budget.capacity() << " bytes, huge cached: " << budget.contains("huge")
+              << std::endl;
+    budget.put("small", std::string(100, 's'));
+    uint64_t evictionsBefore = budget.evictions();
+    budget.visit("medium", [](std::string &value) { value.resize(20000, 'm'); }); // Outgrows it
+    std::cout << "Oversized update: medium cached: " << budget.contains("medium")
+              << ", small cached: " << budget.contains("small")
+              << ", evictions: " << budget.evictions() - evictionsBefore << std::endl;
+
+    // Test 8: Scan resistance, hot keys 0..49 interleaved with one-off cold keys
+    LRUCache<int, int> lru(100);
+    TinyLFUCache<int, int> tinyLfu(100);
+    int coldKey = 1000;
+    for (int round = 0; round < 2000; ++round) {
+        for (int i = 0; i < 10; ++i) {
+            int hot = (round * 10 + i) % 50;
+            if (!lru.get(hot)) lru.put(hot, hot);
+            if (!tinyLfu.get(hot)) tinyLfu.put(hot, hot);
+        }
+        for (int i = 0; i < 20; ++i, ++coldKey) {
+            if (!lru.get(coldKey)) lru.put(coldKey, coldKey);
+            if (!tinyLfu.get(coldKey)) tinyLfu.put(coldKey, coldKey);
+        }
+    }
+    auto ratio = [](uint64_t hits, uint64_t misses) {
+        return static_cast<double>(hits) / static_cast<double>(hits + misses);
+    };
+    std::cout << "Scan workload hit ratio: LRU " << ratio(lru.hits(), lru.misses())
+              << ", W-TinyLFU " << ratio(tinyLfu.hits(), tinyLfu.misses()) << " ("
+              << tinyLfu.evictions() << " evictions)" << std::endl;
+
+    // Test 9: Sharded caches under concurrent readers
+    ConcurrentLRUCache<int, std::string> shared(3, 1);
+    shared.put(1, "one");
+    shared.put(2, "two");
+    shared.put(3, "three");
+    shared.get(1);
+    shared.put(4, "four"); // Single shard keeps exact LRU, so key 2 goes
+    std::cout << "Concurrent cache key 2 exists: " << shared.contains(2) << std::endl;
+
+    ConcurrentLRUCache<int, std::string, Recency::CLOCK> clock(3, 1);
+    clock.put(1, "one");
+    clock.put(2, "two");
+    clock.put(3, "three");
+    clock.get(1);
+    clock.put(4, "four"); // Key 1 gets a second chance, key 2 goes
+    std::cout << "CLOCK cache key 1 exists: " << clock.contains(1) << std::endl;
+    std::cout << "CLOCK cache key 2 exists: " << clock.contains(2) << std::endl;
+
+    const int keys = 1024;
+    ConcurrentLRUCache<int, int> lruShards(keys);
+    ConcurrentLRUCache<int, int, Recency::CLOCK> clockShards(keys);
+    for (int k = 0; k < keys; ++k) {
+        lruShards.put(k, k);
+        clockShards.put(k, k);
+    }
+    for (int threads : {1, 4}) {
+        double lruRate = readThroughput(lruShards, threads, keys, 200000);
+        double clockRate = readThroughput(clockShards, threads, keys, 200000);
+        std::cout << threads << " reader(s): LRU " << lruRate << " gets/s, CLOCK " << clockRate
+                  << " gets/s" << std::endl;
+    }
+
     std::cout << "Tests completed!\n";
     return 0;
 }
\ No newline at end of file
@@ -1,58 +1,630 @@
+#include <algorithm>
+#include <barrier>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
 #include <iostream>
+#include <limits>
+#include <random>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <utility>
 #include <vector>
 
+#if defined(__AVX2__) || defined(__AVX512F__)
+#include <immintrin.h>
+#endif
+
+// Vector kernels for the training sweeps, picked at compile time (AVX-512, AVX2 or scalar)
+namespace kernels {
+// Sum of a[i] * b[i]
+inline double dot(const double *a, const double *b, size_t n) {
+    size_t i = 0;
+    double sum = 0.0;
+#if defined(__AVX512F__)
+    __m512d acc0 = _mm512_setzero_pd();
+    __m512d acc1 = _mm512_setzero_pd();
+    for (; i + 16 <= n; i += 16) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        acc1 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i + 8), _mm512_loadu_pd(b + i + 8), acc1);
+    }
+    if (i + 8 <= n) {
+        acc0 = _mm512_fmadd_pd(_mm512_loadu_pd(a + i), _mm512_loadu_pd(b + i), acc0);
+        i += 8;
+    }
+    double lanes[8];
+    _mm512_storeu_pd(lanes, _mm512_add_pd(acc0, acc1));
+    sum = ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) +
+          ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+#elif defined(__AVX2__)
+    __m256d acc0 = _mm256_setzero_pd();
+    __m256d acc1 = _mm256_setzero_pd();
+    for (; i + 8 <= n; i += 8) {
+#if defined(__FMA__)
+        acc0 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i), acc0);
+        acc1 = _mm256_fmadd_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4), acc1);
+#else
+        acc0 = _mm256_add_pd(acc0, _mm256_mul_pd(_mm256_loadu_pd(a + i), _mm256_loadu_pd(b + i)));
+        acc1 = _mm256_add_pd(
+            acc1, _mm256_mul_pd(_mm256_loadu_pd(a + i + 4), _mm256_loadu_pd(b + i + 4)));
+#endif
+    }
+    double lanes[4];
+    _mm256_storeu_pd(lanes, _mm256_add_pd(acc0, acc1));
+    sum = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+#endif
+    for (; i < n; ++i) {
+        sum += a[i] * b[i];
+    }
+    return sum;
+}
+
+// y[i] += alpha * x[i]
+inline void axpy(double alpha, const double *x, double *y, size_t n) {
+    size_t i = 0;
+#if defined(__AVX512F__)
+    __m512d a8 = _mm512_set1_pd(alpha);
+    for (; i + 8 <= n; i += 8) {
+        __m512d r = _mm512_fmadd_pd(a8, _mm512_loadu_pd(x + i), _mm512_loadu_pd(y + i));
+        _mm512_storeu_pd(y + i, r);
+    }
+#elif defined(__AVX2__)
+    __m256d a4 = _mm256_set1_pd(alpha);
+    for (; i + 4 <= n; i += 4) {
+#if defined(__FMA__)
+        __m256d r = _mm256_fmadd_pd(a4, _mm256_loadu_pd(x + i), _mm256_loadu_pd(y + i));
+#else
+        __m256d r =
+            _mm256_add_pd(_mm256_loadu_pd(y + i), _mm256_mul_pd(a4, _mm256_loadu_pd(x + i)));
+#endif
+        _mm256_storeu_pd(y + i, r);
+    }
+#endif
+    for (; i < n; ++i) {
+        y[i] += alpha * x[i];
+    }
+}
+} // namespace kernels
+
+// Non-owning view of a dense matrix of doubles. Element (i, j) is at
+// data[i * rowStride + j * colStride]; one of the strides must be 1 (row-major or
+// column-major storage).
+struct MatrixView {
+    const double *data;
+    size_t rows;
+    size_t cols;
+    size_t rowStride;
+    size_t colStride;
+
+    static MatrixView rowMajor(const double *data, size_t rows, size_t cols) {
+        return {data, rows, cols, cols, 1};
+    }
+
+    static MatrixView columnMajor(const double *data, size_t rows, size_t cols) {
+        return {data, rows, cols, 1, rows};
+    }
+
+    bool isRowMajor() const {
+        return colStride == 1;
+    }
+
+    double operator()(size_t i, size_t j) const {
+        return data[i * rowStride + j * colStride];
+    }
+
+    const double *row(size_t i) const {
+        return data + i * rowStride;
+    }
+
+    const double *column(size_t j) const {
+        return data + j * colStride;
+    }
+};
+
+// How LinearRegression::fit solves for the weights
+struct SolverConfig {
+    enum Method {
+        GRADIENT_DESCENT, // Full-batch steps at the learning rate
+        NORMAL_EQUATIONS, // Cholesky solve of the centered X^T X; one pass over the data
+        MINI_BATCH_SGD    // Mini-batch steps, each batch's rows split across threads
+    };
+
+    Method method = GRADIENT_DESCENT;
+    // Train on z-scored features (and report weights for the raw ones) so a single learning
+    // rate suits features of any scale. Ignored by NORMAL_EQUATIONS, which needs no scaling.
+    bool standardize = false;
+    // Stop once an iteration (an epoch for MINI_BATCH_SGD) improves the training MSE by less
+    // than this fraction; 0 always runs maxIterations
+    double tolerance = 0.0;
+    size_t batchSize = 256; // Rows per MINI_BATCH_SGD step
+    size_t numThreads = 1;  // MINI_BATCH_SGD threads, including the caller
+    unsigned seed = 42;     // MINI_BATCH_SGD batch order
+
+    // partial_fit (recursive least squares)
+    double forgetting = 1.0;    // Each new sample scales the weight of older ones by this, (0, 1]
+    size_t window = 0;          // Drop a sample once this many newer ones arrived; 0 keeps all
+    double priorVariance = 1e6; // Initial covariance scale: larger trusts the first samples more
+};
+
 class LinearRegression {
   private:
+    // Rows per block when sweeping a column-major matrix: a block of every column stays in
+    // cache between computing its residuals and accumulating its gradient
+    static constexpr size_t BLOCK_ROWS = 256;
+
     std::vector<double> m_coefficients;
     double m_intercept;
     double m_learningRate;
     int m_maxIterations;
+    SolverConfig m_config;
+    int m_iterations = 0;
+
+    // Scratch reused across iterations and fits
+    std::vector<double> m_gradient;
+    std::vector<double> m_residuals;
+
+    // Per-feature mean and standard deviation of the last fit's X (0 and 1 when not scaling)
+    std::vector<double> m_mean;
+    std::vector<double> m_scale;
+
+    // Weights in the standardized space; m_coefficients and m_intercept are derived from them
+    std::vector<double> m_weights;
+    double m_bias = 0.0;
+
+    // partial_fit state over z = [1, x]: weights theta and P, the inverse of the weighted
+    // sum of z z^T (row-major), plus a ring of the last window samples to expire
+    std::vector<double> m_theta;
+    std::vector<double> m_P;
+    std::vector<double> m_Pz;
+    std::vector<double> m_z;
+    std::vector<double> m_windowSamples;
+    std::vector<double> m_windowTargets;
+    size_t m_windowNext = 0;
+    size_t m_windowCount = 0;
+    double m_expiredWeight = 1.0;
+
+    // Predictions for rows [start, start + len) of X, written to out
+    void predictBlock(const MatrixView &X, size_t start, size_t len, double *out) const {
+        if (X.isRowMajor()) {
+            for (size_t k = 0; k < len; ++k) {
+                const double *row = X.row(start + k);
+                out[k] = m_intercept + kernels::dot(m_coefficients.data(), row, X.cols);
+            }
+        } else {
+            std::fill(out, out + len, m_intercept);
+            for (size_t j = 0; j < X.cols; ++j) {
+                kernels::axpy(m_coefficients[j], X.column(j) + start, out, len);
+            }
+        }
+    }
+
+    // One pass over rows [begin, end) of X: adds the squared-error gradient to gradient and the
+    // summed squared error to squared_error, returns the intercept's gradient. residuals is
+    // BLOCK_ROWS of scratch for column-major input.
+    double accumulateGradient(const MatrixView &X, std::span<const double> y, size_t begin,
+                              size_t end, double *gradient, double *residuals,
+                              double &squared_error) const {
+        double intercept_gradient = 0.0;
+        size_t n_features = X.cols;
+        if (X.isRowMajor()) {
+            // Each row is used for its prediction and its gradient term while still in L1
+            for (size_t i = begin; i < end; ++i) {
+                const double *row = X.row(i);
+                double error = m_intercept + kernels::dot(m_coefficients.data(), row, n_features) -
+                               y[i];
+                intercept_gradient += error;
+                squared_error += error * error;
+                kernels::axpy(error, row, gradient, n_features);
+            }
+            return intercept_gradient;
+        }
+
+        for (size_t start = begin; start < end; start += BLOCK_ROWS) {
+            size_t len = std::min(BLOCK_ROWS, end - start);
+            predictBlock(X, start, len, residuals);
+            for (size_t k = 0; k < len; ++k) {
+                residuals[k] -= y[start + k];
+                intercept_gradient += residuals[k];
+                squared_error += residuals[k] * residuals[k];
+            }
+            for (size_t j = 0; j < n_features; ++j) {
+                gradient[j] += kernels::dot(residuals, X.column(j) + start, len);
+            }
+        }
+        return intercept_gradient;
+    }
+
+    // Fills m_mean, and m_scale when scaling; constant columns keep a scale of 1
+    void computeFeatureStats(const MatrixView &X, bool scale) {
+        size_t n_features = X.cols;
+        double n = static_cast<double>(X.rows);
+        std::vector<double> squares(n_features, 0.0);
+        if (X.isRowMajor()) {
+            for (size_t i = 0; i < X.rows; ++i) {
+                kernels::axpy(1.0, X.row(i), m_mean.data(), n_features);
+            }
+            for (size_t j = 0; j < n_features; ++j) {
+                m_mean[j] /= n;
+            }
+            for (size_t i = 0; scale && i < X.rows; ++i) {
+                const double *row = X.row(i);
+                for (size_t j = 0; j < n_features; ++j) {
+                    double d = row[j] - m_mean[j];
+                    squares[j] += d * d;
+                }
+            }
+        } else {
+            for (size_t j = 0; j < n_features; ++j) {
+                const double *column = X.column(j);
+                double sum = 0.0;
+                for (size_t i = 0; i < X.rows; ++i) {
+                    sum += column[i];
+                }
+                m_mean[j] = sum / n;
+                for (size_t i = 0; scale && i < X.rows; ++i) {
+                    double d = column[i] - m_mean[j];
+                    squares[j] += d * d;
+                }
+            }
+        }
+        for (size_t j = 0; scale && j < n_features; ++j) {
+            double sd = std::sqrt(squares[j] / n);
+            if (sd > 0.0) m_scale[j] = sd;
+        }
+    }
+
+    // Maps the standardized weights to m_coefficients/m_intercept in the raw feature space:
+    // b + sum w_j (x_j - mean_j) / scale_j == intercept + sum c_j x_j
+    void publishWeights() {
+        m_intercept = m_bias;
+        for (size_t j = 0; j < m_weights.size(); ++j) {
+            m_coefficients[j] = m_weights[j] / m_scale[j];
+            m_intercept -= m_coefficients[j] * m_mean[j];
+        }
+    }
+
+    // One step in the standardized space from a raw-space gradient: d/dw_j is
+    // (gradient_j - mean_j * intercept_gradient) / scale_j
+    void applyGradient(const double *gradient, double intercept_gradient, double step) {
+        for (size_t j = 0; j < m_weights.size(); ++j) {
+            m_weights[j] -= step * (gradient[j] - m_mean[j] * intercept_gradient) / m_scale[j];
+        }
+        m_bias -= step * intercept_gradient;
+        publishWeights();
+    }
+
+    // True when the loss stopped improving by more than the configured fraction
+    bool converged(double previous, double current) const {
+        return m_config.tolerance > 0.0 && std::isfinite(previous) &&
+               previous - current <= m_config.tolerance * previous;
+    }
+
+    void fitGradientDescent(const MatrixView &X, std::span<const double> y) {
+        m_gradient.resize(X.cols);
+        m_residuals.resize(BLOCK_ROWS);
+        double step = m_learningRate * (2.0 / static_cast<double>(X.rows));
+        double previous = std::numeric_limits<double>::infinity();
+
+        for (m_iterations = 0; m_iterations < m_maxIterations;) {
+            std::fill(m_gradient.begin(), m_gradient.end(), 0.0);
+            double squared_error = 0.0;
+            double intercept_gradient = accumulateGradient(
+                X, y, 0, X.rows, m_gradient.data(), m_residuals.data(), squared_error);
+
+            // The loss is that of the weights before this step
+            if (converged(previous, squared_error)) break;
+            previous = squared_error;
+            applyGradient(m_gradient.data(), intercept_gradient, step);
+            ++m_iterations;
+        }
+    }
+
+    // Solves (Xc^T Xc) w = Xc^T yc for centered Xc and yc, then recovers the intercept from the
+    // means. Centering keeps the system well conditioned when features sit far from zero.
+    void fitNormalEquations(const MatrixView &X, std::span<const double> y) {
+        size_t n_features = X.cols;
+        double y_mean = 0.0;
+        for (double value : y) {
+            y_mean += value;
+        }
+        y_mean /= static_cast<double>(X.rows);
+
+        // Blocks of centered columns, then one dot product per entry of the lower triangle
+        std::vector<double> gram(n_features * n_features, 0.0);
+        std::vector<double> rhs(n_features, 0.0);
+        std::vector<double> block(n_features * BLOCK_ROWS);
+        double yc[BLOCK_ROWS];
+        for (size_t start = 0; start < X.rows; start += BLOCK_ROWS) {
+            size_t len = std::min(BLOCK_ROWS, X.rows - start);
+            for (size_t j = 0; j < n_features; ++j) {
+                double *column = block.data() + j * BLOCK_ROWS;
+                for (size_t k = 0; k < len; ++k) {
+                    column[k] = X(start + k, j) - m_mean[j];
+                }
+            }
+            for (size_t k = 0; k < len; ++k) {
+                yc[k] = y[start + k] - y_mean;
+            }
+            for (size_t j = 0; j < n_features; ++j) {
+                const double *cj = block.data() + j * BLOCK_ROWS;
+                for (size_t l = 0; l <= j; ++l) {
+                    gram[j * n_features + l] +=
+                        kernels::dot(cj, block.data() + l * BLOCK_ROWS, len);
+                }
+                rhs[j] += kernels::dot(cj, yc, len);
+            }
+        }
+
+        // In-place Cholesky: gram's lower triangle becomes L with L L^T == gram
+        for (size_t j = 0; j < n_features; ++j) {
+            double *lj = gram.data() + j * n_features;
+            double diagonal = lj[j] - kernels::dot(lj, lj, j);
+            if (!(diagonal > 1e-12 * std::max(1.0, lj[j]))) {
+                throw std::runtime_error("Features are collinear; X^T X is singular");
+            }
+            lj[j] = std::sqrt(diagonal);
+            for (size_t i = j + 1; i < n_features; ++i) {
+                double *li = gram.data() + i * n_features;
+                li[j] = (li[j] - kernels::dot(li, lj, j)) / lj[j];
+            }
+        }
+
+        // L z = rhs, then L^T w = z
+        for (size_t i = 0; i < n_features; ++i) {
+            const double *li = gram.data() + i * n_features;
+            rhs[i] = (rhs[i] - kernels::dot(li, rhs.data(), i)) / li[i];
+        }
+        for (size_t i = n_features; i-- > 0;) {
+            double sum = rhs[i];
+            for (size_t k = i + 1; k < n_features; ++k) {
+                sum -= gram[k * n_features + i] * rhs[k];
+            }
+            rhs[i] = sum / gram[i * n_features + i];
+        }
+
+        m_weights = std::move(rhs);
+        m_bias = y_mean;
+        publishWeights();
+        m_iterations = 1;
+    }
+
+    // Each step takes one batch of batchSize rows and splits it across numThreads threads; the
+    // barrier's completion step sums their partial gradients and applies the update while the
+    // threads wait, so every batch sees the weights left by the one before. Batches are
+    // contiguous rows visited in a fresh random order each epoch.
+    void fitMiniBatch(const MatrixView &X, std::span<const double> y) {
+        size_t n_features = X.cols;
+        size_t threads = m_config.numThreads;
+        size_t batch_rows = std::min(m_config.batchSize, X.rows);
+        size_t batches = (X.rows + batch_rows - 1) / batch_rows;
+
+        // Per-thread gradient, intercept gradient and squared error, padded to cache lines
+        size_t stride = (n_features + 2 + 7) / 8 * 8;
+        std::vector<double> partials(threads * stride);
+        std::vector<double> residuals(threads * BLOCK_ROWS);
+        m_gradient.resize(n_features);
+
+        std::vector<size_t> order(batches);
+        for (size_t b = 0; b < batches; ++b) {
+            order[b] = b;
+        }
+        std::mt19937 rng(m_config.seed);
+        std::shuffle(order.begin(), order.end(), rng);
+
+        size_t position = 0;
+        double epoch_error = 0.0;
+        double previous = std::numeric_limits<double>::infinity();
+        bool done = m_maxIterations <= 0;
+        m_iterations = 0;
+
+        auto reduce = [&]() noexcept {
+            size_t begin = order[position] * batch_rows;
+            size_t rows = std::min(batch_rows, X.rows - begin);
+            std::fill(m_gradient.begin(), m_gradient.end(), 0.0);
+            double intercept_gradient = 0.0;
+            for (size_t t = 0; t < threads; ++t) {
+                double *partial = partials.data() + t * stride;
+                kernels::axpy(1.0, partial, m_gradient.data(), n_features);
+                intercept_gradient += partial[n_features];
+                epoch_error += partial[n_features + 1];
+            }
+            applyGradient(m_gradient.data(), intercept_gradient,
+                          m_learningRate * (2.0 / static_cast<double>(rows)));
+
+            if (++position < batches) return;
+            // End of an epoch; its loss is summed over batches as they were trained
+            ++m_iterations;
+            done = m_iterations >= m_maxIterations || converged(previous, epoch_error);
+            previous = epoch_error;
+            epoch_error = 0.0;
+            position = 0;
+            std::shuffle(order.begin(), order.end(), rng);
+        };
+        std::barrier sync(static_cast<std::ptrdiff_t>(threads), reduce);
+
+        // position and done only change inside the completion step, between phases
+        auto work = [&](size_t t) {
+            double *partial = partials.data() + t * stride;
+            while (!done) {
+                size_t begin = order[position] * batch_rows;
+                size_t rows = std::min(batch_rows, X.rows - begin);
+                size_t slice_begin = begin + rows * t / threads;
+                size_t slice_end = begin + rows * (t + 1) / threads;
+                std::fill(partial, partial + n_features + 2, 0.0);
+                partial[n_features] =
+                    accumulateGradient(X, y, slice_begin, slice_end, partial,
+                                       residuals.data() + t * BLOCK_ROWS, partial[n_features + 1]);
+                sync.arrive_and_wait();
+            }
+        };
+
+        std::vector<std::thread> helpers;
+        for (size_t t = 1; t < threads; ++t) {
+            helpers.emplace_back(work, t);
+        }
+        work(0);
+        for (auto &helper : helpers) {
+            helper.join();
+        }
+    }
+
+    // Starts recursive least squares from the current weights (zero if the feature count
+    // differs) with covariance priorVariance * I
+    void startOnline(size_t n_features) {
+        size_t n = n_features + 1;
+        m_theta.assign(n, 0.0);
+        if (m_coefficients.size() == n_features) {
+            m_theta[0] = m_intercept;
+            std::copy(m_coefficients.begin(), m_coefficients.end(), m_theta.begin() + 1);
+        } else {
+            m_coefficients.assign(n_features, 0.0);
+            m_intercept = 0.0;
+        }
+        m_P.assign(n * n, 0.0);
+        for (size_t i = 0; i < n; ++i) {
+            m_P[i * n + i] = m_config.priorVariance;
+        }
+        m_Pz.resize(n);
+        m_z.resize(n);
+        m_windowSamples.resize(m_config.window * n);
+        m_windowTargets.resize(m_config.window);
+        m_windowNext = 0;
+        m_windowCount = 0;
+        m_expiredWeight = std::pow(m_config.forgetting, static_cast<double>(m_config.window));
+    }
+
+    // Sherman-Morrison update for adding weight * z z^T to the information matrix (a negative
+    // weight removes a sample). Only the lower triangle of P is computed and then mirrored, so
+    // P stays exactly symmetric however many updates it takes.
+    void rankOneUpdate(const double *z, double y, double weight) {
+        size_t n = m_theta.size();
+        for (size_t i = 0; i < n; ++i) {
+            m_Pz[i] = kernels::dot(m_P.data() + i * n, z, n);
+        }
+        double denominator = 1.0 + weight * kernels::dot(z, m_Pz.data(), n);
+        // A downdate that would leave P indefinite (rounding on a near-duplicate) is skipped
+        if (!(denominator > 1e-12)) return;
+
+        double gain = weight * (y - kernels::dot(z, m_theta.data(), n)) / denominator;
+        kernels::axpy(gain, m_Pz.data(), m_theta.data(), n);
+        double c = weight / denominator;
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t j = 0; j <= i; ++j) {
+                double value = m_P[i * n + j] - c * m_Pz[i] * m_Pz[j];
+                m_P[i * n + j] = value;
+                m_P[j * n + i] = value;
+            }
+        }
+    }
 
   public:
-    LinearRegression(double learningRate = 0.01, int maxIterations = 1000)
-        : m_intercept(0.0), m_learningRate(learningRate), m_maxIterations(maxIterations) {}
+    LinearRegression(double learningRate = 0.01, int maxIterations = 1000,
+                     const SolverConfig &config = {})
+        : m_intercept(0.0), m_learningRate(learningRate), m_maxIterations(maxIterations),
+          m_config(config) {
+        if (m_config.batchSize == 0) {
+            throw std::invalid_argument("Batch size must be positive");
+        }
+        if (m_config.numThreads == 0) {
+            throw std::invalid_argument("At least one thread is required");
+        }
+        if (!(m_config.forgetting > 0.0 && m_config.forgetting <= 1.0)) {
+            throw std::invalid_argument("Forgetting factor must be in (0, 1]");
+        }
+        if (!(m_config.priorVariance > 0.0)) {
+            throw std::invalid_argument("Prior variance must be positive");
+        }
+    }
 
     void fit(const std::vector<std::vector<double>> &X, const std::vector<double> &y) {
         if (X.empty() || y.empty() || X.size() != y.size()) {
             return; // Handle edge case
         }
 
-        int n_samples = X.size();
-        int n_features = X[0].size();
+        // Pack the rows once so every iteration streams contiguous memory
+        size_t n_features = X[0].size();
+        std::vector<double> packed;
+        packed.reserve(X.size() * n_features);
+        for (const auto &sample : X) {
+            if (sample.size() != n_features) return;
+            packed.insert(packed.end(), sample.begin(), sample.end());
+        }
+        fit(MatrixView::rowMajor(packed.data(), X.size(), n_features), y);
+    }
+
+    void fit(const MatrixView &X, std::span<const double> y) {
+        if (X.rows == 0 || X.rows != y.size()) {
+            return; // Handle edge case
+        }
+
+        m_theta.clear(); // The next partial_fit warm-starts from this fit
+        // Unscaled descent trains in the raw space (mean 0, scale 1); the normal equations only
+        // need the means, for centering
+        bool normal_equations = m_config.method == SolverConfig::NORMAL_EQUATIONS;
+        m_mean.assign(X.cols, 0.0);
+        m_scale.assign(X.cols, 1.0);
+        if (normal_equations || m_config.standardize) {
+            computeFeatureStats(X, !normal_equations);
+        }
 
         // Initialize coefficients to zero
-        m_coefficients.assign(n_features, 0.0);
-        m_intercept = 0.0;
-
-        // Gradient descent
-        for (int iter = 0; iter < m_maxIterations; ++iter) {
-            // Calculate predictions
-            std::vector<double> predictions(n_samples);
-            for (int i = 0; i < n_samples; ++i) {
-                predictions[i] = m_intercept;
-                for (int j = 0; j < n_features; ++j) {
-                    predictions[i] += m_coefficients[j] * X[i][j];
-                }
-            }
+        m_coefficients.assign(X.cols, 0.0);
+        m_weights.assign(X.cols, 0.0);
+        m_bias = 0.0;
+        publishWeights();
 
-            // Calculate gradients
-            std::vector<double> coeff_gradients(n_features, 0.0);
-            double intercept_gradient = 0.0;
+        switch (m_config.method) {
+        case SolverConfig::GRADIENT_DESCENT:
+            fitGradientDescent(X, y);
+            break;
+        case SolverConfig::NORMAL_EQUATIONS:
+            fitNormalEquations(X, y);
+            break;
+        case SolverConfig::MINI_BATCH_SGD:
+            fitMiniBatch(X, y);
+            break;
+        }
+    }
 
-            for (int i = 0; i < n_samples; ++i) {
-                double error = predictions[i] - y[i];
-                intercept_gradient += error;
-                for (int j = 0; j < n_features; ++j) {
-                    coeff_gradients[j] += error * X[i][j];
-                }
+    // Online update with one sample in O(features^2): recursive least squares with the
+    // configured forgetting factor and window. The first call warm-starts from the last fit.
+    void partial_fit(std::span<const double> sample, double y) {
+        size_t n = sample.size() + 1;
+        if (m_theta.empty()) {
+            startOnline(sample.size());
+        } else if (n != m_theta.size()) {
+            throw std::invalid_argument("Sample has a different number of features than the model");
+        }
+
+        // Decaying every older sample's weight by lambda divides P by it
+        if (m_config.forgetting < 1.0) {
+            double inverse = 1.0 / m_config.forgetting;
+            for (double &value : m_P) {
+                value *= inverse;
             }
+        }
+
+        double *z = m_z.data();
+        z[0] = 1.0;
+        std::copy(sample.begin(), sample.end(), z + 1);
+        rankOneUpdate(z, y, 1.0);
 
-            // Update parameters
-            m_intercept -= m_learningRate * (2.0 / n_samples) * intercept_gradient;
-            for (int j = 0; j < n_features; ++j) {
-                m_coefficients[j] -= m_learningRate * (2.0 / n_samples) * coeff_gradients[j];
+        if (m_config.window > 0) {
+            // The oldest sample now has weight lambda^window: remove exactly that much
+            double *slot = m_windowSamples.data() + m_windowNext * n;
+            if (m_windowCount == m_config.window) {
+                rankOneUpdate(slot, m_windowTargets[m_windowNext], -m_expiredWeight);
+            } else {
+                ++m_windowCount;
             }
+            std::copy(z, z + n, slot);
+            m_windowTargets[m_windowNext] = y;
+            m_windowNext = (m_windowNext + 1) % m_config.window;
         }
+
+        m_intercept = m_theta[0];
+        std::copy(m_theta.begin() + 1, m_theta.end(), m_coefficients.begin());
     }
 
     std::vector<double> predict(const std::vector<std::vector<double>> &X) const {
@@ -78,6 +650,11 @@ class LinearRegression {
         return m_intercept;
     }
 
+    // Passes over the data taken by the last fit (epochs for MINI_BATCH_SGD)
+    int getIterations() const {
+        return m_iterations;
+    }
+
     double getMeanSquaredError(const std::vector<std::vector<double>> &X,
                                const std::vector<double> &y) const {
         if (X.size() != y.size() || X.empty()) {
@@ -94,21 +671,104 @@ class LinearRegression {
 
         return mse / y.size();
     }
+
+    // out[i] is the prediction for row i of X
+    void predict(const MatrixView &X, std::span<double> out) const {
+        if (out.size() != X.rows) {
+            throw std::invalid_argument("Output has a different number of rows than X");
+        }
+        for (size_t start = 0; start < X.rows; start += BLOCK_ROWS) {
+            predictBlock(X, start, std::min(BLOCK_ROWS, X.rows - start), out.data() + start);
+        }
+    }
+
+    double getMeanSquaredError(const MatrixView &X, std::span<const double> y) const {
+        if (X.rows != y.size() || X.rows == 0) {
+            return 0.0;
+        }
+
+        double block[BLOCK_ROWS];
+        double mse = 0.0;
+        for (size_t start = 0; start < X.rows; start += BLOCK_ROWS) {
+            size_t len = std::min(BLOCK_ROWS, X.rows - start);
+            predictBlock(X, start, len, block);
+            for (size_t k = 0; k < len; ++k) {
+                double error = block[k] - y[start + k];
+                mse += error * error;
+            }
+        }
+
+        return mse / static_cast<double>(y.size());
+    }
 };
 
+// Synthetic y = X * weights + 0.5 + noise, stored both ways. Features are standard normal, or
+// with spread each sits at 5 standard deviations from zero with scales from 1 to 1000.
+struct SyntheticData {
+    size_t rows;
+    size_t cols;
+    std::vector<double> rowMajor;
+    std::vector<double> columnMajor;
+    std::vector<double> y;
+    std::vector<double> weights;
+};
+
+SyntheticData makeSyntheticData(size_t rows, size_t cols, unsigned seed, bool spread = false) {
+    std::mt19937 rng(seed);
+    std::normal_distribution<double> normal(0.0, 1.0);
+    SyntheticData data{rows, cols, std::vector<double>(rows * cols),
+                       std::vector<double>(rows * cols), std::vector<double>(rows), {}};
+    std::vector<double> scales;
+    for (size_t j = 0; j < cols; ++j) {
+        scales.push_back(spread ? std::pow(10.0, static_cast<double>(j % 4)) : 1.0);
+        data.weights.push_back(static_cast<double>(j + 1) * (j % 2 ? -1.0 : 1.0) / scales[j]);
+    }
+    for (size_t i = 0; i < rows; ++i) {
+        double target = 0.5 + 0.01 * normal(rng);
+        for (size_t j = 0; j < cols; ++j) {
+            double x = scales[j] * ((spread ? 5.0 : 0.0) + normal(rng));
+            data.rowMajor[i * cols + j] = x;
+            data.columnMajor[j * rows + i] = x;
+            target += data.weights[j] * x;
+        }
+        data.y[i] = target;
+    }
+    return data;
+}
+
+// Time a fit and report how close it got to the true weights (relative to each weight)
+void reportFit(const char *label, LinearRegression &model, const MatrixView &X,
+               const SyntheticData &data) {
+    auto start = std::chrono::steady_clock::now();
+    model.fit(X, data.y);
+    double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double worst = std::abs(model.getIntercept() - 0.5);
+    auto coefficients = model.getCoefficients();
+    for (size_t j = 0; j < data.cols; ++j) {
+        worst = std::max(worst, std::abs(coefficients[j] / data.weights[j] - 1.0));
+    }
+    std::cout << label << ": " << seconds * 1e3 << " ms, " << model.getIterations()
+              << " iterations, MSE " << model.getMeanSquaredError(X, data.y)
+              << ", max weight error " << worst << std::endl;
+}
+
 // Test the implementation
 int main() {
     // Data: price = a*size + b*bedrooms + c
     std::vector<std::vector<double>> X = {{1000, 2}, {1500, 3}, {2000, 4}, {2500, 5}, {1200, 2}};
     std::vector<double> y = {150000, 200000, 250000, 300000, 160000};
 
-    LinearRegression lr(0.000001, 2000); // Small learning rate for large numbers
+    // Closed form: no learning rate to tune for the units of size and price
+    SolverConfig normal;
+    normal.method = SolverConfig::NORMAL_EQUATIONS;
+    LinearRegression lr(0.0, 0, normal);
     lr.fit(X, y);
 
     auto predictions = lr.predict(X);
     auto coefficients = lr.getCoefficients();
 
-    std::cout << "Trained model:" << std::endl;
+    std::cout << "Trained model (" << lr.getIterations() << " iterations):" << std::endl;
     std::cout << "Intercept: " << lr.getIntercept() << std::endl;
     for (size_t i = 0; i < coefficients.size(); ++i) {
         std::cout << "Coefficient " << i << ": " << coefficients[i] << std::endl;
@@ -131,5 +791,82 @@ int main() {
                   << " -> Price: " << test_predictions[i] << std::endl;
     }
 
+    // Contiguous storage, one fused sweep per iteration
+    std::cout << "\nContiguous fit, 500000 x 16, 100 iterations:" << std::endl;
+    {
+        SyntheticData data = makeSyntheticData(500000, 16, 7);
+        LinearRegression model(0.1, 100);
+        reportFit("Row-major", model,
+                  MatrixView::rowMajor(data.rowMajor.data(), data.rows, data.cols), data);
+        reportFit("Column-major", model,
+                  MatrixView::columnMajor(data.columnMajor.data(), data.rows, data.cols), data);
+    }
+
+    // Solvers on features of mixed scale and offset
+    std::cout << "\nSolvers, 500000 x 16, unscaled features:" << std::endl;
+    {
+        SyntheticData data = makeSyntheticData(500000, 16, 11, true);
+        MatrixView view = MatrixView::rowMajor(data.rowMajor.data(), data.rows, data.cols);
+
+        LinearRegression closedForm(0.0, 0, normal);
+        reportFit("Normal equations", closedForm, view, data);
+
+        // Standardized features let one learning rate work whatever the units
+        SolverConfig descent;
+        descent.standardize = true;
+        descent.tolerance = 1e-9;
+        LinearRegression fullBatch(0.5, 1000, descent);
+        reportFit("Standardized gradient descent", fullBatch, view, data);
+
+        SolverConfig sgd = descent;
+        sgd.method = SolverConfig::MINI_BATCH_SGD;
+        sgd.batchSize = 4096;
+        sgd.tolerance = 1e-3;
+        LinearRegression oneThread(0.1, 50, sgd);
+        reportFit("Mini-batch SGD, 1 thread", oneThread, view, data);
+        sgd.numThreads = 4;
+        LinearRegression fourThreads(0.1, 50, sgd);
+        reportFit("Mini-batch SGD, 4 threads", fourThreads, view, data);
+    }
+
+    // Online refits on a stream whose first slope flips from 2 to -1 halfway through
+    std::cout << "\nOnline partial_fit, 200000 samples x 4, regime change at 100000:" << std::endl;
+    {
+        const size_t samples = 200000;
+        const size_t n_features = 4;
+        std::mt19937 rng(3);
+        std::normal_distribution<double> normal(0.0, 1.0);
+        std::vector<double> stream(samples * n_features);
+        std::vector<double> targets(samples);
+        for (size_t i = 0; i < samples; ++i) {
+            double *x = stream.data() + i * n_features;
+            double slope = i < samples / 2 ? 2.0 : -1.0;
+            for (size_t j = 0; j < n_features; ++j) {
+                x[j] = normal(rng);
+            }
+            targets[i] = 0.3 + slope * x[0] + 0.5 * x[1] - 0.25 * x[2] + 0.1 * normal(rng);
+        }
+
+        SolverConfig cumulative;
+        SolverConfig decaying;
+        decaying.forgetting = 0.999;
+        SolverConfig windowed;
+        windowed.window = 2000;
+        std::pair<const char *, SolverConfig> models[] = {
+            {"Cumulative", cumulative}, {"Forgetting 0.999", decaying}, {"Window 2000", windowed}};
+        for (const auto &[name, config] : models) {
+            LinearRegression online(0.01, 1000, config);
+            auto start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < samples; ++i) {
+                online.partial_fit({stream.data() + i * n_features, n_features}, targets[i]);
+            }
+            double seconds =
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+            std::cout << name << ": " << seconds * 1e9 / samples
+                      << " ns/update, slope " << online.getCoefficients()[0] << " (true -1)"
+                      << ", intercept " << online.getIntercept() << " (true 0.3)" << std::endl;
+        }
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -1,135 +1,15 @@
-#include <cmath>
+#include <atomic>
+#include <chrono>
 #include <cstdlib>
-#include <deque>
+#include <filesystem>
 #include <iostream>
+#include <iterator>
 #include <string>
-#include <unordered_map>
-
-struct Tick {
-    long long timestamp; // milliseconds since epoch
-    std::string symbol;
-    double price;
-    int volume;
-};
-
-class MarketDataProcessor {
-  private:
-    std::unordered_map<std::string, std::deque<Tick>> symbolMap;
-
-    static const long TIME_WINDOW_MS = 60000;
-    static const int MIN_PRICES_FOR_STDDEV = 20;
-
-    // Remove old ticks outside the time window
-    void cleanOldTicks(const std::string &symbol, long currentTime) {
-        auto it = symbolMap.find(symbol);
-        if (it == symbolMap.end()) return;
-        auto &ticks = it->second;
-        while (!ticks.empty() && (currentTime - ticks.back().timestamp) > TIME_WINDOW_MS) {
-            ticks.pop_back();
-        }
-    }
-
-    // Get the most recent timestamp for a symbol
-    long getLatestTimestamp(const std::string &symbol) const {
-        auto it = symbolMap.find(symbol);
-        if (it == symbolMap.end() || it->second.empty()) {
-            return 0;
-        }
-        return it->second.front().timestamp;
-    }
-
-  public:
-    MarketDataProcessor() = default;
-
-    // Process a tick
-    void processTick(const Tick &tick) {
-        symbolMap[tick.symbol].push_front(tick);
-        cleanOldTicks(tick.symbol, tick.timestamp);
-    }
-
-    // Moving average over 1 minute (60000ms)
-    double getMovingAverage(const std::string &symbol) const {
-        auto it = symbolMap.find(symbol);
-        if (it == symbolMap.end() || it->second.empty()) return 0.;
-
-        const auto &ticks = it->second;
-        double sum = 0.0;
-        for (const auto &tick : ticks) {
-            sum += tick.price;
-        }
-
-        return sum / static_cast<double>(ticks.size());
-    }
-
-    // Detect anomaly (price > mean + 3*standard_deviation)
-    bool isAnomaly(const std::string &symbol, double price) const {
-        auto it = symbolMap.find(symbol);
-        if (it == symbolMap.end() || static_cast<int>(it->second.size()) < MIN_PRICES_FOR_STDDEV) {
-            return false;
-        }
-        const auto &ticks = it->second;
-        double variance = 0.;
-        double mean = getMovingAverage(symbol);
-        for (auto &tick : ticks) {
-            variance += std::pow(tick.price - mean, 2);
-        }
-        variance /= static_cast<int>(it->second.size());
-        double std_dev = std::sqrt(variance);
-
-        return price > mean + 3 * std_dev ? true : false;
-    }
-
-    // Stats for debugging
-    void printStats(const std::string &symbol) const {
-        auto it = symbolMap.find(symbol);
-        if (it == symbolMap.end()) {
-            std::cout << "No data for symbol: " << symbol << std::endl;
-            return;
-        }
-
-        const auto &ticks = it->second;
-        std::cout << "=== Stats for " << symbol << " ===" << std::endl;
-        std::cout << "Number of ticks in window: " << ticks.size() << std::endl;
-
-        if (!ticks.empty()) {
-            std::cout << "Time range: " << ticks.front().timestamp << " to "
-                      << ticks.back().timestamp << " ms" << std::endl;
-            std::cout << "Moving average: " << getMovingAverage(symbol) << std::endl;
-
-            if (ticks.size() >= MIN_PRICES_FOR_STDDEV) {
-                double mean = getMovingAverage(symbol);
-                double variance = 0.0;
-                for (const auto &tick : ticks) {
-                    double diff = tick.price - mean;
-                    variance += diff * diff;
-                }
-                variance /= ticks.size();
-                double stddev = std::sqrt(variance);
-                std::cout << "Standard deviation: " << stddev << std::endl;
-                std::cout << "Anomaly threshold (mean + 3σ): " << (mean + 3.0 * stddev)
-                          << std::endl;
-            } else {
-                std::cout << "Insufficient data for anomaly detection (need "
-                          << MIN_PRICES_FOR_STDDEV << " prices)" << std::endl;
-            }
-
-            // Show price range
-            double minPrice = ticks[0].price, maxPrice = ticks[0].price;
-            for (const auto &tick : ticks) {
-                minPrice = std::min(minPrice, tick.price);
-                maxPrice = std::max(maxPrice, tick.price);
-            }
-            std::cout << "Price range: [" << minPrice << ", " << maxPrice << "]" << std::endl;
-        }
-        std::cout << std::endl;
-    }
+#include <thread>
+#include <vector>
 
-    // Get number of ticks for a symbol (for testing)
-    size_t getTickCount(const std::string &symbol) {
-        auto it = symbolMap.find(symbol);
-        return it == symbolMap.end() ? 0 : it->second.size();
-    }
-};
+#include "../include/MarketDataProcessor.hpp"
+#include "../include/TickRecord.hpp"
 
 // Example usage and test
 int main() {
@@ -139,11 +19,12 @@ int main() {
 
     // Simulate AAPL tick stream
     long baseTime = 1000000000000L; // Start time
+    const long long MS = 1000000;   // Nanoseconds per millisecond, for TickRecord timestamps
 
     // Add initial ticks with normal prices around 150
     for (int i = 0; i < 25; i++) {
         double price = 150.0 + (rand() % 5 - 2) * 0.5; // Random price 148-152
-        processor.processTick({baseTime + i * 1000, "AAPL", price, 100 + i});
+        processor.processTick(TickRecord::make("AAPL", price, 100 + i, (baseTime + i * 1000) * MS));
     }
 
     processor.printStats("AAPL");
@@ -158,25 +39,146 @@ int main() {
                   << std::endl;
     }
 
+    // Whole batch against a single threshold
+    bool flags[std::size(testPrices)];
+    size_t anomalies = processor.isAnomaly("AAPL", testPrices, flags);
+    std::cout << "Batch check: " << anomalies << " of " << std::size(testPrices)
+              << " prices are anomalies" << std::endl;
+
     // Add some GOOGL data
     std::cout << "\n=== Adding GOOGL data ===" << std::endl;
     for (int i = 0; i < 30; i++) {
         double price = 2800.0 + (rand() % 10 - 5) * 2.0; // Random price around 2800
-        processor.processTick({baseTime + i * 2000, "GOOGL", price, 50 + i});
+        processor.processTick(TickRecord::make("GOOGL", price, 50 + i, (baseTime + i * 2000) * MS));
     }
 
     processor.printStats("GOOGL");
 
+    // Hot path by id: no string hashing or copies per tick
+    SymbolId msft = processor.registerSymbol("MSFT");
+    for (int i = 0; i < 30; i++) {
+        processor.processTick(msft, baseTime + i * 1000, 410.0 + (i % 3), 200);
+    }
+    std::cout << "MSFT (id " << msft << ") moving average: " << processor.getMovingAverage(msft)
+              << ", 500.0 anomaly: " << processor.isAnomaly(msft, 500.0) << std::endl
+              << std::endl;
+
     // Test time window by adding old data
     std::cout << "=== Time Window Test ===" << std::endl;
     std::cout << "AAPL ticks before adding old data: " << processor.getTickCount("AAPL")
               << std::endl;
 
-    // Add a very recent tick to trigger cleanup
-    processor.processTick({baseTime + 65000, "AAPL", 151.0, 500}); // 65 seconds later
+    // Add a very recent tick to trigger cleanup, 65 seconds later
+    processor.processTick(TickRecord::make("AAPL", 151.0, 500, (baseTime + 65000) * MS));
 
     std::cout << "AAPL ticks after 65-second gap: " << processor.getTickCount("AAPL") << std::endl;
     processor.printStats("AAPL");
 
+    // Percentile rule: flag prices above the window's p99.9 instead of assuming normality
+    std::cout << "=== Percentile Anomaly Rule ===" << std::endl;
+    AnomalyRule percentileRule;
+    percentileRule.mode = AnomalyRule::PERCENTILE;
+    percentileRule.percentile = 0.999;
+    MarketDataProcessor skewed(percentileRule);
+    SymbolId tsla = skewed.registerSymbol("TSLA");
+    for (int i = 0; i < 5000; i++) {
+        // Mostly near 250 with a long right tail
+        double price = 250.0 + (rand() % 100) * 0.01 + (i % 250 == 0 ? 15.0 : 0.0);
+        skewed.processTick(tsla, baseTime + i * 10, price, 100);
+    }
+    std::cout << "TSLA min " << skewed.getMinPrice(tsla) << ", max " << skewed.getMaxPrice(tsla)
+              << ", median " << skewed.getPercentile(tsla, 0.5) << ", p99.9 "
+              << skewed.getPercentile(tsla, 0.999) << std::endl;
+    for (double testPrice : {251.0, 262.0, 270.0}) {
+        std::cout << "Price " << testPrice << " is "
+                  << (skewed.isAnomaly(tsla, testPrice) ? "ANOMALY" : "normal") << std::endl;
+    }
+
+    // Sharded ingestion with lock-free readers
+    std::cout << "\n=== Sharded Processor ===" << std::endl;
+    const size_t numShards = 4;
+    const int numSymbols = 64;
+    const int ticksPerSymbol = 20000;
+    ShardedMarketDataProcessor sharded(numShards);
+    std::vector<SymbolId> ids;
+    for (int i = 0; i < numSymbols; i++) {
+        ids.push_back(sharded.registerSymbol("SYM" + std::to_string(i)));
+    }
+    sharded.start();
+
+    // Reader polls snapshots while the feed runs
+    std::atomic<bool> feeding{true};
+    std::atomic<long> reads{0};
+    std::thread reader([&]() {
+        while (feeding.load(std::memory_order_relaxed)) {
+            for (SymbolId id : ids) {
+                sharded.isAnomaly(id, 1e9);
+                reads.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    });
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::thread> feeds;
+    for (int f = 0; f < 2; f++) {
+        // Each feed thread owns half of the symbols, so per-symbol order is kept
+        feeds.emplace_back([&, f]() {
+            for (int i = 0; i < ticksPerSymbol; i++) {
+                for (int s = f; s < numSymbols; s += 2) {
+                    double price = 100.0 + s + (i % 10) * 0.1;
+                    sharded.processTick(ids[s], baseTime + i * 5, price, 100);
+                }
+            }
+        });
+    }
+    for (auto &feed : feeds) {
+        feed.join();
+    }
+    sharded.stop();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    feeding = false;
+    reader.join();
+
+    SymbolSnapshot snapshot = sharded.getSnapshot(ids[5]);
+    std::cout << "Ingested " << numSymbols * ticksPerSymbol << " ticks on " << numShards
+              << " shards at " << static_cast<long>(numSymbols * ticksPerSymbol / elapsed.count())
+              << " ticks/s, " << reads << " concurrent reads" << std::endl;
+    std::cout << "SYM5: " << snapshot.tickCount << " ticks, average " << snapshot.movingAverage
+              << ", range [" << snapshot.minPrice << ", " << snapshot.maxPrice << "]" << std::endl;
+
+    // Replay from a tick file: records are used in place from the mapping
+    std::cout << "\n=== Tick File Replay ===" << std::endl;
+    std::string path = (std::filesystem::temp_directory_path() / "market_data_ticks.bin").string();
+    const int replayTicks = 2000000;
+    {
+        TickFileWriter writer(path);
+        std::vector<TickRecord> chunk;
+        for (int i = 0; i < replayTicks; i++) {
+            std::string symbol = "SYM" + std::to_string(i % 16);
+            chunk.push_back(TickRecord::make(symbol, 100.0 + (i % 16) + (i % 7) * 0.01, 100,
+                                             (baseTime + i / 16) * MS));
+            if (chunk.size() == 4096) {
+                writer.write(chunk);
+                chunk.clear();
+            }
+        }
+        writer.write(chunk);
+        writer.close();
+    }
+    {
+        TickFileReader reader(path);
+        MarketDataProcessor replayed;
+        auto replayStart = std::chrono::steady_clock::now();
+        replayed.processTicks(reader.records());
+        std::chrono::duration<double> replayTime = std::chrono::steady_clock::now() - replayStart;
+        std::cout << "Replayed " << reader.size() << " records ("
+                  << reader.size() * sizeof(TickRecord) / (1 << 20) << " MiB) at "
+                  << static_cast<long>(static_cast<double>(reader.size()) / replayTime.count())
+                  << " ticks/s" << std::endl;
+        std::cout << "SYM3 moving average " << replayed.getMovingAverage("SYM3") << " over "
+                  << replayed.getTickCount("SYM3") << " ticks" << std::endl;
+    }
+    std::filesystem::remove(path);
+
     return 0;
 }
\ No newline at end of file
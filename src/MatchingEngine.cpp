@@ -0,0 +1,89 @@
+#include <atomic>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../include/MatchingEngine.hpp"
+
+// Usage example and test
+int main() {
+    std::cout << "=== MULTI-SYMBOL MATCHING ENGINE TEST ===" << std::endl;
+
+    const size_t numShards = 2;
+
+    // One ring per shard: each worker is the only producer of its ring
+    std::vector<std::unique_ptr<EventRing>> rings;
+    for (size_t i = 0; i < numShards; ++i) {
+        rings.push_back(std::make_unique<EventRing>(4096));
+    }
+
+    MatchingEngine<RingSink> engine(numShards, [&rings](size_t shard, uint32_t symbol) {
+        return RingSink(*rings[shard], symbol);
+    });
+
+    MatchingEngine<RingSink>::BookConfig ladder;
+    ladder.tickSize = 0.01;
+    ladder.minPrice = 1.0;
+    ladder.maxPrice = 5000.0;
+    ladder.reserveOrders = 1024;
+
+    auto aapl = engine.addSymbol("AAPL", ladder);
+    auto msft = engine.addSymbol("MSFT", ladder);
+    auto googl = engine.addSymbol("GOOGL", ladder);
+    auto tsla = engine.addSymbol("TSLA"); // std::map book
+
+    for (auto id : {aapl, msft, googl, tsla}) {
+        std::cout << engine.symbolName(id) << " -> shard " << engine.shardOf(id) << std::endl;
+    }
+
+    // Reporter thread drains every shard's ring and does the formatting
+    std::atomic<bool> done{false};
+    std::atomic<int> trades{0};
+    std::thread reporter([&]() {
+        auto print = [&](const ExecutionEvent &e) {
+            if (e.type == ExecutionEvent::TRADE) {
+                trades++;
+                std::cout << "[" << engine.symbolName(e.symbol) << "] Trade: BUY/SELL "
+                          << e.trade.aggressorID << "/" << e.trade.restingID << " at "
+                          << e.trade.price << " x " << e.trade.quantity << std::endl;
+            }
+        };
+        while (!done.load(std::memory_order_acquire)) {
+            size_t drained = 0;
+            for (auto &ring : rings) {
+                drained += ring->drain(print, 256);
+            }
+            if (drained == 0) std::this_thread::yield();
+        }
+        for (auto &ring : rings) {
+            ring->drain(print);
+        }
+    });
+
+    engine.start();
+
+    engine.addOrder(aapl, OrderBook::BUY, 150.00, 100, 1);
+    engine.addOrder(aapl, OrderBook::SELL, 150.00, 40, 2);
+    engine.addOrder(msft, OrderBook::SELL, 410.50, 10, 1);
+    engine.addOrder(msft, OrderBook::BUY, 411.00, 25, 2);
+    engine.addOrder(googl, OrderBook::BUY, 2800.00, 5, 1);
+    engine.addOrder(tsla, OrderBook::SELL, 250.0, 30, 1);
+    engine.addOrder(tsla, OrderBook::BUY, 251.0, 10, 2);
+    engine.cancelOrder(googl, 1);
+    engine.modifyOrder(aapl, 1, 20);
+
+    engine.stop();
+    done.store(true, std::memory_order_release);
+    reporter.join();
+
+    std::cout << "\nTrades reported: " << trades << std::endl;
+    for (auto id : {aapl, msft, googl, tsla}) {
+        const auto &book = engine.book(id);
+        std::cout << engine.symbolName(id) << ": best bid " << book.getBestBid() << ", best ask "
+                  << (book.getBestAsk() == DBL_MAX ? 0 : book.getBestAsk()) << std::endl;
+    }
+
+    return 0;
+}
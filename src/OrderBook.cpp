@@ -1,192 +1,8 @@
-#include <algorithm>
-#include <cfloat>
-#include <deque>
+#include <atomic>
 #include <iostream>
-#include <map>
-#include <unordered_map>
+#include <thread>
 
-class OrderBook {
-  public:
-    enum Side { BUY, SELL };
-
-  private:
-    struct Order {
-        int orderID;
-        double price;
-        int quantity;
-        long long timestamp;
-
-        Order(int id, double p, int q, long long ts)
-            : orderID(id), price(p), quantity(q), timestamp(ts) {}
-    };
-
-    std::map<double, std::deque<Order>, std::greater<double>> bids;
-    std::map<double, std::deque<Order>> asks;
-
-    std::unordered_map<int, std::pair<Side, double>> orderLocation;
-
-    double bestBid;
-    double bestAsk;
-
-    long long currentTimestamp;
-
-    void updateBestPrices() {
-        bestBid = bids.empty() ? 0.0 : bids.begin()->first;
-        bestAsk = asks.empty() ? DBL_MAX : asks.begin()->first;
-    }
-
-    void matchOrders(Side side, double price, int &quantity, int orderID) {
-        if (side == BUY) {
-            while (quantity > 0 && !asks.empty() && asks.begin()->first <= price) {
-                auto &askQueue = asks.begin()->second;
-                while (quantity > 0 && !askQueue.empty()) {
-                    Order &askOrder = askQueue.front();
-                    int tradeQty = std::min(quantity, askOrder.quantity);
-                    quantity -= tradeQty;
-                    askOrder.quantity -= tradeQty;
-
-                    std::cout << "Trade executed: BUY ID=" << orderID
-                              << " with SELL ID=" << askOrder.orderID
-                              << " at Price=" << askOrder.price << " Qty=" << tradeQty << std::endl;
-
-                    if (askOrder.quantity == 0) {
-                        orderLocation.erase(askOrder.orderID);
-                        askQueue.pop_front();
-                    }
-                }
-                if (askQueue.empty()) {
-                    asks.erase(asks.begin());
-                }
-            }
-        } else {
-            while (quantity > 0 && !bids.empty() && bids.begin()->first >= price) {
-                auto &bidQueue = bids.begin()->second;
-                while (quantity > 0 && !bidQueue.empty()) {
-                    Order &bidOrder = bidQueue.front();
-                    int tradeQty = std::min(quantity, bidOrder.quantity);
-                    quantity -= tradeQty;
-                    bidOrder.quantity -= tradeQty;
-
-                    std::cout << "Trade executed: SELL ID=" << orderID
-                              << " with BUY ID=" << bidOrder.orderID
-                              << " at Price=" << bidOrder.price << " Qty=" << tradeQty << std::endl;
-
-                    if (bidOrder.quantity == 0) {
-                        orderLocation.erase(bidOrder.orderID);
-                        bidQueue.pop_front();
-                    }
-                }
-                if (bidQueue.empty()) {
-                    bids.erase(bids.begin());
-                }
-            }
-        }
-    }
-
-  public:
-    OrderBook() : bestBid(0.0), bestAsk(DBL_MAX), currentTimestamp(0) {}
-
-    // Add an order
-    void addOrder(Side side, double price, int quantity, int orderID) {
-        if (quantity <= 0) {
-            std::cerr << "Quantity must be positive." << std::endl;
-            return;
-        }
-
-        currentTimestamp++;
-
-        matchOrders(side, price, quantity, orderID);
-
-        if (side == BUY) {
-            if (quantity > 0) {
-                bids[price].emplace_back(orderID, price, quantity, currentTimestamp);
-                orderLocation[orderID] = {BUY, price};
-                std::cout << "Added BUY order: ID=" << orderID << ", Price=" << price
-                          << ", Qty=" << quantity << std::endl;
-            } else {
-                std::cout << "BUY order ID=" << orderID << " fully executed upon entry."
-                          << std::endl;
-            }
-        } else {
-            if (quantity > 0) {
-                asks[price].emplace_back(orderID, price, quantity, currentTimestamp);
-                orderLocation[orderID] = {SELL, price};
-                std::cout << "Added SELL order: ID=" << orderID << ", Price=" << price
-                          << ", Qty=" << quantity << std::endl;
-            } else {
-                std::cout << "SELL order ID=" << orderID << " fully executed upon entry."
-                          << std::endl;
-            }
-        }
-        updateBestPrices();
-    }
-
-    // Cancel an order
-    bool cancelOrder(int orderID) {
-        auto it = orderLocation.find(orderID);
-        if (it == orderLocation.end()) {
-            std::cerr << "Order ID=" << orderID << " not found for cancellation." << std::endl;
-            return false;
-        }
-        Side side = it->second.first;
-        double price = it->second.second;
-        auto &orderQueue = (side == BUY) ? bids[price] : asks[price];
-        orderQueue.erase(std::remove_if(orderQueue.begin(), orderQueue.end(),
-                                        [orderID](const Order &o) { return o.orderID == orderID; }),
-                         orderQueue.end());
-        if (orderQueue.empty()) {
-            if (side == BUY) {
-                bids.erase(price);
-            } else {
-                asks.erase(price);
-            }
-        }
-
-        orderLocation.erase(it);
-        std::cout << "Cancelled order ID=" << orderID << std::endl;
-        updateBestPrices();
-        return true;
-    }
-
-    // Get best bid/ask in O(1)
-    double getBestBid() const {
-        return bestBid;
-    }
-    double getBestAsk() const {
-        return bestAsk;
-    }
-
-    // Display order book (for debugging)
-    void printOrderBook() const {
-        std::cout << "\n=== ORDER BOOK ===" << std::endl;
-
-        // Display asks in descending order (highest ask at top)
-        std::cout << "ASKS (SELL orders):" << std::endl;
-        for (auto it = asks.rbegin(); it != asks.rend(); ++it) {
-            int totalQty = 0;
-            for (const auto &order : it->second) {
-                totalQty += order.quantity;
-            }
-            std::cout << "  $" << it->first << " | " << totalQty << " shares" << std::endl;
-        }
-
-        std::cout << "---" << std::endl;
-        std::cout << "Best Ask: $" << (bestAsk == DBL_MAX ? 0 : bestAsk) << std::endl;
-        std::cout << "Best Bid: $" << bestBid << std::endl;
-        std::cout << "---" << std::endl;
-
-        // Display bids in descending order (highest bid at top)
-        std::cout << "BIDS (BUY orders):" << std::endl;
-        for (const auto &level : bids) {
-            int totalQty = 0;
-            for (const auto &order : level.second) {
-                totalQty += order.quantity;
-            }
-            std::cout << "  $" << level.first << " | " << totalQty << " shares" << std::endl;
-        }
-        std::cout << "==================\n" << std::endl;
-    }
-};
+#include "../include/OrderBook.hpp"
 
 // Usage example and test
 int main() {
@@ -229,5 +45,82 @@ int main() {
     std::cout << "Best Bid: $" << book.getBestBid() << std::endl;
     std::cout << "Best Ask: $" << book.getBestAsk() << std::endl;
 
+    // Same flow on a price ladder: $0.01 ticks between $50 and $150
+    std::cout << "\n=== PRICE LADDER MODE ===" << std::endl;
+    OrderBook ladder(0.01, 50.0, 150.0);
+    ladder.addOrder(OrderBook::BUY, 100.0, 10, 1);
+    ladder.addOrder(OrderBook::SELL, 101.0, 5, 2);
+    ladder.addOrder(OrderBook::SELL, 99.0, 8, 3);
+    ladder.addOrder(OrderBook::BUY, 98.0, 5, 4);
+    ladder.addOrder(OrderBook::BUY, 98.0, 3, 5);
+    ladder.addOrder(OrderBook::SELL, 102.0, 7, 6);
+    ladder.cancelOrder(5);
+    ladder.modifyOrder(4, 2);                        // Shrinks in place, keeps priority
+    ladder.addOrder(OrderBook::SELL, 97.0, 10, 7);
+    ladder.addOrder(OrderBook::BUY, 200.0, 1, 8);    // Rejected: outside the band
+    ladder.addOrder(OrderBook::BUY, 100.005, 1, 9);  // Rejected: off the tick grid
+    ladder.printOrderBook();
+
+    std::cout << "Best Bid: $" << ladder.getBestBid() << std::endl;
+    std::cout << "Best Ask: $" << ladder.getBestAsk() << std::endl;
+
+    // Depth snapshot, then follow changes from its sequence number
+    std::cout << "\n=== DEPTH API ===" << std::endl;
+    OrderBook::DepthLevel depth[10];
+    uint64_t snapshotSeq = ladder.getSequence();
+    size_t levels = ladder.getDepth(OrderBook::SELL, depth, 10);
+    for (size_t i = 0; i < levels; ++i) {
+        std::cout << "  Ask L" << i + 1 << ": $" << depth[i].price << " x " << depth[i].quantity
+                  << " (" << depth[i].orderCount << " orders)" << std::endl;
+    }
+    ladder.addOrder(OrderBook::SELL, 101.0, 4, 10);
+    ladder.addOrder(OrderBook::BUY, 97.0, 6, 11);
+    OrderBook::LevelUpdate updates[16];
+    size_t updateCount = 0;
+    if (ladder.getLevelUpdates(snapshotSeq, updates, 16, updateCount)) {
+        for (size_t i = 0; i < updateCount; ++i) {
+            std::cout << "  Update #" << updates[i].sequence << ": "
+                      << (updates[i].side == OrderBook::BUY ? "BID" : "ASK") << " $"
+                      << updates[i].price << " -> " << updates[i].quantity << " ("
+                      << updates[i].orderCount << " orders)" << std::endl;
+        }
+    }
+    OrderBook::OrderInfo queue[8];
+    size_t queued = ladder.getOrders(OrderBook::SELL, 101.0, queue, 8);
+    std::cout << "  Orders at $101:";
+    for (size_t i = 0; i < queued; ++i) {
+        std::cout << " #" << queue[i].orderID << "x" << queue[i].quantity;
+    }
+    std::cout << std::endl;
+
+    // Reports go to a ring and a second thread drains them, keeping I/O off the matching path
+    std::cout << "\n=== RING BUFFER SINK ===" << std::endl;
+    EventRing ring(1024);
+    std::atomic<bool> done{false};
+    std::thread reporter([&ring, &done]() {
+        PrintingSink printer;
+        auto print = [&printer](const ExecutionEvent &e) {
+            switch (e.type) {
+            case ExecutionEvent::TRADE: printer.onTrade(e.trade); break;
+            case ExecutionEvent::ACK: printer.onAck(e.ack); break;
+            case ExecutionEvent::CANCEL: printer.onCancel(e.cancel); break;
+            case ExecutionEvent::REJECT: printer.onReject(e.reject); break;
+            }
+        };
+        while (!done.load(std::memory_order_acquire)) {
+            if (ring.drain(print, 64) == 0) std::this_thread::yield();
+        }
+        ring.drain(print);
+    });
+
+    BasicOrderBook<RingSink> gateway(0.01, 50.0, 150.0, RingSink(ring));
+    gateway.addOrder(OrderBook::BUY, 100.0, 10, 1);
+    gateway.addOrder(OrderBook::BUY, 100.0, 5, 2);
+    gateway.addOrder(OrderBook::SELL, 99.5, 12, 3);
+    gateway.cancelOrder(2);
+    gateway.cancelOrder(42);
+    done.store(true, std::memory_order_release);
+    reporter.join();
+
     return 0;
 }
\ No newline at end of file
@@ -1,117 +1,87 @@
+#include <atomic>
 #include <chrono>
-#include <condition_variable>
-#include <cstddef>
 #include <iostream>
 #include <mutex>
-#include <queue>
-#include <stdexcept>
+#include <optional>
 #include <thread>
+#include <vector>
 
 #include "../include/ThreadSafeQueue.hpp"
 
-template <typename T>
-ThreadSafeQueue<T>::ThreadSafeQueue(size_t maxSize) : max_size_(maxSize), shutdown_(false) {}
-
-template <typename T> ThreadSafeQueue<T>::~ThreadSafeQueue() {
-    shutdown();
-}
-
-// Add an element (blocks if full)
-template <typename T> void ThreadSafeQueue<T>::push(const T &item) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    notFull_.wait(lock, [this]() { return queue_.size() < max_size_ || shutdown_; });
-    if (shutdown_) {
-        throw std::runtime_error("Queue is shutting down.");
+// Items per second through a queue with the given number of producers and as many consumers
+template <typename Policy> double queueThroughput(int threads, int itemsPerProducer) {
+    ThreadSafeQueue<int, Policy> queue(1024);
+    std::atomic<long long> consumedSum{0};
+    std::vector<std::thread> workers;
+    auto start = std::chrono::steady_clock::now();
+    for (int c = 0; c < threads; ++c) {
+        workers.emplace_back([&queue, &consumedSum]() {
+            long long sum = 0;
+            try {
+                while (true) {
+                    sum += queue.pop();
+                }
+            } catch (const std::runtime_error &) {
+                // Shut down and drained
+            }
+            consumedSum += sum;
+        });
     }
-    queue_.push(item);
-    notEmpty_.notify_one();
-}
-
-// Move version of push
-template <typename T> void ThreadSafeQueue<T>::push(T &&item) {
-    std::unique_lock<std::mutex> lock(mutex_);
-    notFull_.wait(lock, [this]() { return queue_.size() < max_size_ || shutdown_; });
-    if (shutdown_) {
-        throw std::runtime_error("Queue is shutting down.");
+    std::vector<std::thread> producers;
+    for (int p = 0; p < threads; ++p) {
+        producers.emplace_back([&queue, itemsPerProducer]() {
+            for (int i = 1; i <= itemsPerProducer; ++i) {
+                queue.push(i);
+            }
+        });
     }
-    queue_.push(std::move(item));
-    notEmpty_.notify_one();
-}
-
-// Non-blocking version (returns false if full)
-template <typename T> bool ThreadSafeQueue<T>::tryPush(const T &item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (queue_.size() >= max_size_ || shutdown_) {
-        return false;
+    for (auto &t : producers) {
+        t.join();
     }
-
-    queue_.push(item);
-    notEmpty_.notify_one();
-    return true;
-}
-
-// Move version of tryPush
-template <typename T> bool ThreadSafeQueue<T>::tryPush(T &&item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (queue_.size() >= max_size_ || shutdown_) {
-        return false;
+    queue.shutdown();
+    for (auto &t : workers) {
+        t.join();
     }
-
-    queue_.push(std::move(item));
-    notEmpty_.notify_one();
-    return true;
-}
-
-// Get an element (blocks if empty)
-template <typename T> T ThreadSafeQueue<T>::pop() {
-    std::unique_lock<std::mutex> lock(mutex_);
-    notEmpty_.wait(lock, [this]() { return !queue_.empty() || shutdown_; });
-
-    if (shutdown_ && queue_.empty()) {
-        throw std::runtime_error("Queue is shutting down.");
+    auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start);
+    long long expected = static_cast<long long>(threads) * itemsPerProducer *
+                         (itemsPerProducer + 1) / 2;
+    if (consumedSum != expected) {
+        std::cout << "  item mismatch: " << consumedSum << " != " << expected << std::endl;
     }
-
-    T item = std::move(queue_.front());
-    queue_.pop();
-    notFull_.notify_one();
-    return item;
-}
-
-// Non-blocking version (returns false if empty)
-template <typename T> bool ThreadSafeQueue<T>::tryPop(T &item) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (queue_.empty()) return false;
-
-    item = std::move(queue_.front());
-    queue_.pop();
-    notFull_.notify_one();
-    return true;
-}
-
-// Current size
-template <typename T> size_t ThreadSafeQueue<T>::size() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.size();
-}
-
-// Check if queue is empty
-template <typename T> bool ThreadSafeQueue<T>::empty() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return queue_.empty();
-}
-
-// Clean shutdown (for thread termination)
-template <typename T> void ThreadSafeQueue<T>::shutdown() {
-    std::lock_guard<std::mutex> lock(mutex_);
-    shutdown_ = true;
-    notEmpty_.notify_all();
-    notFull_.notify_all();
+    return threads * static_cast<double>(itemsPerProducer) / elapsed.count();
 }
 
-// Check if shutdown
-template <typename T> bool ThreadSafeQueue<T>::isShutdown() const {
-    std::lock_guard<std::mutex> lock(mutex_);
-    return shutdown_;
+// A fast producer against a slow consumer, reported through the queue's stats
+template <typename Policy> void printQueueStats(const char *name) {
+    ThreadSafeQueue<int, Policy, QueueStats> queue(64);
+    std::thread consumer([&queue]() {
+        try {
+            for (int received = 0;; ++received) {
+                queue.pop();
+                if (received % 64 == 0) std::this_thread::sleep_for(std::chrono::microseconds(200));
+            }
+        } catch (const std::runtime_error &) {
+            // Shut down and drained
+        }
+    });
+    for (int i = 0; i < 5000; ++i) {
+        if (!queue.tryPush(i)) queue.push(i);
+    }
+    while (!queue.empty()) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    queue.shutdown();
+    consumer.join();
+
+    QueueStatsSnapshot stats = queue.stats();
+    std::cout << name << ": enqueued " << stats.enqueued << ", dequeued " << stats.dequeued
+              << ", failed tryPush " << stats.failedTryPush << ", high water " << stats.highWater
+              << std::endl;
+    std::cout << "  producer blocked " << stats.pushBlockedNs.count() << " times, p50 "
+              << stats.pushBlockedNs.percentile(0.5) << " ns; consumer blocked "
+              << stats.popBlockedNs.count() << " times" << std::endl;
+    std::cout << "  push-to-pop latency p50 " << stats.latencyNs.percentile(0.5) << " ns, p99 "
+              << stats.latencyNs.percentile(0.99) << " ns" << std::endl;
 }
 
 // Example usage and testing
@@ -343,6 +313,108 @@ int main() {
         std::cout << "Statistics: Produced=" << produced << ", Consumed=" << consumed << std::endl;
     }
 
+    // Test 5: Bulk and timed operations
+    {
+        std::cout << "\n--- Test 5: Bulk and timed operations ---" << std::endl;
+        ThreadSafeQueue<int> queue(8);
+
+        std::vector<int> batch = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+        size_t pushed = queue.tryPushBulk(batch);
+        std::cout << "tryPushBulk of 10 into capacity 8: " << pushed << " pushed" << std::endl;
+
+        std::vector<int> out(4);
+        size_t popped = queue.popBulk(out, 3);
+        std::cout << "popBulk(max 3):";
+        for (size_t i = 0; i < popped; ++i) {
+            std::cout << " " << out[i];
+        }
+        std::cout << " (queue size: " << queue.size() << ")" << std::endl;
+
+        // A blocking bulk push: 6 items with room for 3, so it only completes once a late
+        // consumer has started taking the 11 items. The consumer raises its flag before its
+        // first pop, so a push that waited for that pop always sees it.
+        std::atomic<bool> consuming{false};
+        std::thread consumer([&queue, &consuming]() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(20));
+            consuming = true;
+            std::vector<int> drained(16);
+            size_t drainedCount = 0;
+            while (drainedCount < 11) {
+                drainedCount += queue.popBulk(drained);
+            }
+        });
+        queue.pushBulk(std::vector<int>{11, 12, 13, 14, 15, 16});
+        bool blocked = consuming.load();
+        consumer.join();
+        std::cout << "pushBulk of 6 with room for 3 waited for the consumer: "
+                  << (blocked ? "yes" : "no") << ", size: " << queue.size() << std::endl;
+
+        auto start = std::chrono::steady_clock::now();
+        std::optional<int> item = queue.popFor(std::chrono::milliseconds(50));
+        auto waited = std::chrono::duration_cast<std::chrono::milliseconds>(
+            std::chrono::steady_clock::now() - start);
+        std::cout << "popFor(50ms) on empty queue: " << (item ? "item" : "timeout") << " after "
+                  << waited.count() << " ms" << std::endl;
+
+        queue.push(42);
+        int value = 0;
+        bool got = queue.tryPopUntil(value, std::chrono::steady_clock::now() +
+                                                std::chrono::milliseconds(50));
+        std::cout << "tryPopUntil with an item queued: " << (got ? "got " : "timeout ") << value
+                  << std::endl;
+
+        queue.shutdown();
+        std::cout << "tryPopUntil after shutdown: "
+                  << (queue.tryPopUntil(value, std::chrono::steady_clock::now()) ? "item"
+                                                                                 : "false")
+                  << std::endl;
+    }
+
+    // Test 6: Lock-free queue, same semantics
+    {
+        std::cout << "\n--- Test 6: Lock-free policy ---" << std::endl;
+        ThreadSafeQueue<int, LockFreePolicy> queue(4);
+        for (int i = 1; i <= 5; ++i) {
+            bool pushed = queue.tryPush(i);
+            std::cout << "tryPush(" << i << "): " << (pushed ? "ok" : "full") << std::endl;
+        }
+        int value;
+        queue.tryPop(value);
+        std::cout << "tryPop: " << value << ", size: " << queue.size() << std::endl;
+        queue.shutdown();
+        std::cout << "tryPush after shutdown: " << (queue.tryPush(9) ? "ok" : "failed")
+                  << std::endl;
+        int drained = 0;
+        try {
+            while (true) {
+                queue.pop();
+                drained++;
+            }
+        } catch (const std::exception &e) {
+            std::cout << "Drained " << drained << ", then: " << e.what() << std::endl;
+        }
+    }
+
+    // Test 7: Throughput with N producers and N consumers
+    {
+        std::cout << "\n--- Test 7: Throughput scaling ---" << std::endl;
+        const int items = 200000;
+        for (int threads : {1, 2, 4, 8}) {
+            double locked = queueThroughput<MutexPolicy>(threads, items / threads);
+            double lockFree = queueThroughput<LockFreePolicy>(threads, items / threads);
+            std::cout << threads << "x" << threads << ": mutex " << static_cast<long>(locked)
+                      << " items/s, lock-free " << static_cast<long>(lockFree) << " items/s"
+                      << std::endl;
+        }
+    }
+
+    // Test 8: Queue instrumentation
+    {
+        std::cout << "\n--- Test 8: Queue stats ---" << std::endl;
+        printQueueStats<MutexPolicy>("mutex");
+        printQueueStats<LockFreePolicy>("lock-free");
+    }
+
     std::cout << "\n=== All tests completed! ===" << std::endl;
     return 0;
 }
\ No newline at end of file
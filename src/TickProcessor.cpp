@@ -1,159 +1,34 @@
 #include <atomic>
 #include <chrono>
-#include <condition_variable>
 #include <iostream>
-#include <mutex>
-#include <queue>
-#include <shared_mutex>
 #include <string>
 #include <thread>
-#include <unordered_map>
 #include <vector>
 
-template <typename T> class ThreadSafeQueue {
-  private:
-    mutable std::mutex mtx_;
-    std::queue<T> queue_;
-    std::condition_variable condition_;
-
-  public:
-    void push(T item) {
-        std::lock_guard<std::mutex> lock(mtx_);
-        queue_.push(item);
-        condition_.notify_one();
-    }
-
-    bool tryPop(T &item) {
-        std::lock_guard<std::mutex> lock(mtx_);
-        if (queue_.empty()) {
-            return false;
-        }
-        item = queue_.front();
-        queue_.pop();
-        return true;
-    }
-
-    bool waitAndPop(T &item, const std::chrono::milliseconds &timeout) {
-        std::unique_lock<std::mutex> lock(mtx_);
-        if (condition_.wait_for(lock, timeout, [this] { return !queue_.empty(); })) {
-            item = queue_.front();
-            queue_.pop();
-            return true;
-        }
-        return false;
-    }
-
-    bool empty() const {
-        std::lock_guard<std::mutex> lock(mtx_);
-        return queue_.empty();
-    }
-};
-
-struct Tick {
-    std::string symbol;
-    double price;
-    int volume;
-
-    Tick() = default;
-    Tick(std::string s, double p, int v) : symbol(s), price(p), volume(v) {}
-};
-
-struct VWAPData {
-    double vwap = 0.0;
-    double totalValue = 0.0;
-    int totalVolume = 0;
-};
-
-class TickProcessor {
-  private:
-    ThreadSafeQueue<Tick> tickQueue_;
-    std::unordered_map<std::string, VWAPData> vwapData_;
-    mutable std::shared_mutex vwapMutex_;
-
-    std::thread processorThread_;
-    std::atomic<bool> running_{false};
-    std::atomic<int> ticksProcessed_{0};
-
-  public:
-    ~TickProcessor() {
-        if (running_.load()) {
-            stop();
-        }
-    }
-
-    void start() {
-        bool expected = false;
-        if (running_.compare_exchange_strong(expected, true)) {
-            processorThread_ = std::thread(&TickProcessor::processorLoop, this);
-        }
-    }
-
-    void stop() {
-        bool expected = true;
-        if (running_.compare_exchange_strong(expected, false)) {
-            if (processorThread_.joinable()) {
-                processorThread_.join();
-            }
-        }
-    }
-
-    void addTick(const Tick &tick) {
-        if (running_.load()) {
-            tickQueue_.push(tick);
-        }
-    }
-
-    double getVWAP(const std::string &symbol) const {
-        std::shared_lock<std::shared_mutex> lock(vwapMutex_);
-        auto it = vwapData_.find(symbol);
-        if (it != vwapData_.end()) {
-            return it->second.vwap;
-        }
-        return 0.0;
-    }
-
-    int getProcessedCount() const {
-        return ticksProcessed_.load();
-    }
-
-  private:
-    void processorLoop() {
-        while (running_.load()) {
-            Tick tick;
-            if (tickQueue_.waitAndPop(tick, std::chrono::milliseconds(100))) {
-                if (validateTick(tick)) {
-                    updateVWAP(tick);
-                    ticksProcessed_.fetch_add(1);
-                }
-            }
-        }
-
-        Tick tick;
-        while (tickQueue_.tryPop(tick)) {
-            if (validateTick(tick)) {
-                updateVWAP(tick);
-                ticksProcessed_.fetch_add(1);
-            }
-        }
-    }
-
-    bool validateTick(const Tick &tick) const {
-        return !tick.symbol.empty() && tick.price > 0.0 && tick.volume > 0;
+#include "../include/CircularBuffer.hpp"
+#include "../include/LatencyHistogram.hpp"
+#include "../include/TickProcessor.hpp"
+
+// Ticks per second from first enqueue to last update, for a burst over a few symbols
+double burstThroughput(size_t workers, const BatchConfig &config,
+                       std::vector<std::vector<int>> affinity = {}) {
+    const int ticks = 1000000;
+    const std::vector<std::string> symbols = {"AAPL", "GOOGL", "MSFT", "AMZN",
+                                              "META", "NVDA", "TSLA", "NFLX"};
+    TickProcessor<SpscQueue<Tick, 4096, SpinPark>> processor(workers, config,
+                                                             std::move(affinity));
+    processor.start();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) {
+        processor.addTick({symbols[i % symbols.size()], 100.0 + i % 10, 1 + i % 5});
     }
-
-    void updateVWAP(const Tick &tick) {
-        std::unique_lock<std::shared_mutex> lock(vwapMutex_);
-
-        VWAPData &vwap_data = vwapData_[tick.symbol];
-
-        vwap_data.totalValue += tick.price * tick.volume;
-        vwap_data.totalVolume += tick.volume;
-
-        if (vwap_data.totalVolume > 0) {
-            vwap_data.vwap = vwap_data.totalValue / vwap_data.totalVolume;
-        }
+    while (processor.getProcessedCount() < ticks) {
+        std::this_thread::yield();
     }
-};
+    auto end = std::chrono::steady_clock::now();
+    processor.stop();
+    return ticks / std::chrono::duration<double>(end - start).count();
+}
 
 int main() {
     std::cout << "=== Tests for the Tick Processor ===" << std::endl;
@@ -183,5 +58,112 @@ int main() {
 
     processor.stop();
 
+    // Same ticks through the lock-free SPSC ring with a parking consumer
+    TickProcessor<SpscQueue<Tick, 4096, SpinPark>> spscProcessor;
+    spscProcessor.start();
+    for (const auto &tick : testTicks) {
+        spscProcessor.addTick(tick);
+    }
+    while (spscProcessor.getProcessedCount() < static_cast<int>(testTicks.size())) {
+        std::this_thread::yield();
+    }
+    std::cout << "\n=== SPSC Results ===" << std::endl;
+    std::cout << "VWAP AAPL: " << spscProcessor.getVWAP("AAPL") << std::endl;
+    std::cout << "VWAP GOOGL: " << spscProcessor.getVWAP("GOOGL") << std::endl;
+
+    // Same ticks as shared TickRecords
+    std::vector<TickRecord> records;
+    for (const auto &tick : testTicks) {
+        records.push_back(TickRecord::make(tick.symbol, tick.price, tick.volume, 0));
+    }
+    TickProcessor<> fromRecords;
+    fromRecords.start();
+    fromRecords.addTicks(records);
+    while (fromRecords.getProcessedCount() < static_cast<int>(records.size())) {
+        std::this_thread::yield();
+    }
+    std::cout << "\n=== TickRecord Results ===" << std::endl;
+    std::cout << "VWAP AAPL: " << fromRecords.getVWAP("AAPL") << std::endl;
+    fromRecords.stop();
+
+    // Same ticks over two symbol-partitioned workers
+    TickProcessor<> partitioned(2);
+    partitioned.start();
+    for (const auto &tick : testTicks) {
+        partitioned.addTick(tick);
+    }
+    partitioned.stop();
+    std::cout << "\n=== 2-Worker Results ===" << std::endl;
+    std::cout << "Ticks treated: " << partitioned.getProcessedCount() << std::endl;
+    std::cout << "VWAP AAPL: " << partitioned.getVWAP("AAPL") << std::endl;
+    std::cout << "VWAP GOOGL: " << partitioned.getVWAP("GOOGL") << std::endl;
+    std::vector<SymbolVWAP> all;
+    partitioned.getAllVWAPs(all);
+    for (const auto &entry : all) {
+        std::cout << entry.symbol << ": vwap " << entry.data.vwap << ", volume "
+                  << entry.data.totalVolume << std::endl;
+    }
+
+    // Enqueue-to-update latency, one tick in flight at a time
+    LatencyHistogram latency;
+    for (int i = 0; i < 10000; ++i) {
+        int before = spscProcessor.getProcessedCount();
+        auto t0 = std::chrono::steady_clock::now();
+        spscProcessor.addTick({"AAPL", 150.0, 1});
+        while (spscProcessor.getProcessedCount() == before) {
+            cpuRelax();
+        }
+        auto t1 = std::chrono::steady_clock::now();
+        latency.record(static_cast<uint64_t>(
+            std::chrono::duration_cast<std::chrono::nanoseconds>(t1 - t0).count()));
+    }
+    std::cout << "Enqueue-to-VWAP latency: p50 " << latency.percentile(0.5) << " ns, p99 "
+              << latency.percentile(0.99) << " ns" << std::endl;
+    spscProcessor.stop();
+
+    // Burst throughput, per-tick publishing against batches of 256
+    std::cout << "\n=== Burst Throughput ===" << std::endl;
+    std::cout << "Per tick:     " << burstThroughput(1, BatchConfig()) << " ticks/s" << std::endl;
+    BatchConfig batched{256, std::chrono::microseconds(50)};
+    std::cout << "Batch of 256: " << burstThroughput(1, batched) << " ticks/s" << std::endl;
+
+    // Symbol-partitioned workers, each kept on NUMA node 0's cores when the node is known
+    std::vector<int> node0 = TickProcessor<>::numaNodeCpus(0);
+    std::cout << "NUMA node 0 cores: " << node0.size() << std::endl;
+    std::cout << "4 workers:    " << burstThroughput(4, batched, {node0, node0, node0, node0})
+              << " ticks/s" << std::endl;
+
+    // Dashboard-style polling of every symbol while a burst is being processed
+    {
+        TickProcessor<> polled(2, batched);
+        polled.start();
+        std::atomic<bool> done{false};
+        long snapshots = 0;
+        bool consistent = true;
+        std::thread reader([&]() {
+            std::vector<SymbolVWAP> all;
+            while (!done.load()) {
+                polled.getAllVWAPs(all);
+                for (const auto &entry : all) {
+                    consistent &= entry.data.vwap * entry.data.totalVolume ==
+                                  entry.data.totalValue;
+                }
+                snapshots++;
+            }
+        });
+        const std::vector<std::string> symbols = {"AAPL", "GOOGL", "MSFT", "AMZN"};
+        for (int i = 0; i < 200000; ++i) {
+            // One price per symbol, so a torn read would show as vwap * volume != value
+            polled.addTick({symbols[i % symbols.size()], 100.0 + 100.0 * (i % 4), 1 + i % 3});
+        }
+        while (polled.getProcessedCount() < 200000) {
+            std::this_thread::yield();
+        }
+        done.store(true);
+        reader.join();
+        std::cout << "\nPolled " << snapshots << " snapshots during the burst, consistent: "
+                  << consistent << std::endl;
+    }
+
     return 0;
 }
\ No newline at end of file
@@ -1,72 +1,10 @@
-#include <deque>
 #include <iomanip>
 #include <iostream>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
-struct Tick {
-    double price;
-    int volume;
-
-    Tick(double p, int v) : price(p), volume(v) {}
-};
-
-class VWAPCalculator {
-  private:
-    std::deque<Tick> ticks;
-    int windowSize;
-    double totalPriceVolume;
-    long long totalVolume;
-
-  public:
-    VWAPCalculator(int windowSize = 100)
-        : windowSize(windowSize), totalPriceVolume(0.0), totalVolume(0) {
-        if (windowSize <= 0) {
-            throw std::invalid_argument("Window size must be positive");
-        }
-    }
-
-    // Add a tick
-    void addTick(double price, int volume) {
-        if (volume <= 0) {
-            throw std::invalid_argument("Volume must be positive");
-        }
-
-        if (windowSize <= getTickCount()) {
-            const Tick &victim = ticks.front();
-            totalPriceVolume -= victim.price * victim.volume;
-            totalVolume -= victim.volume;
-            ticks.pop_front();
-        }
-
-        ticks.emplace_back(price, volume);
-        totalPriceVolume += price * volume;
-        totalVolume += volume;
-    }
-
-    // Calculate current VWAP
-    double getVWAP() const {
-        if (totalVolume == 0) return 0.;
-        return totalPriceVolume / totalVolume;
-    }
-
-    // Number of ticks in window
-    int getTickCount() const {
-        return static_cast<int>(ticks.size());
-    }
-
-    long long getTotalVolume() const {
-        return totalVolume;
-    }
-
-    double getTotalPriceVolume() const {
-        return totalPriceVolume;
-    }
-
-    void clear() {
-        ticks.clear();
-        totalPriceVolume = 0.;
-        totalVolume = 0;
-    }
-};
+#include "../include/VWAPCalculator.hpp"
 
 int main() {
     std::cout << "=== VWAP Calculator Demo ===" << std::endl;
@@ -111,5 +49,81 @@ int main() {
         }
     }
 
+    // Same example with the window fixed at compile time
+    std::cout << "\n=== Testing with compile-time window (3) ===" << std::endl;
+    VWAPCalculator<3> fixed;
+    for (auto [price, volume] : {std::pair{100.0, 10}, {102.0, 20}, {98.0, 30}, {104.0, 40}}) {
+        fixed.addTick(price, volume);
+    }
+    std::cout << "VWAP: " << fixed.getVWAP() << " (Expected: 101.5556)" << std::endl;
+
+    // Long run: periodic recompute keeps the running totals exact
+    VWAPCalculator<100> longRun;
+    for (int i = 1; i <= 1000000; ++i) {
+        longRun.addTick(100.0 + 0.01 * (i % 97), 1 + i % 7);
+    }
+    std::cout << "After 1000000 ticks - VWAP: " << longRun.getVWAP()
+              << ", Window size: " << longRun.getTickCount() << std::endl;
+
+    // Batch ingestion from columns gives the same results as tick-by-tick
+    std::cout << "\n=== Testing batch ingestion ===" << std::endl;
+    std::vector<double> prices;
+    std::vector<int> volumes;
+    for (int i = 1; i <= 150; ++i) {
+        prices.push_back(100.0 + (i % 20) - 10);
+        volumes.push_back(10 + (i % 5));
+    }
+    VWAPCalculator batch;
+    batch.addTicks(prices, volumes);
+    std::cout << "Batch of 150 - VWAP: " << batch.getVWAP()
+              << ", Window size: " << batch.getTickCount() << std::endl;
+
+    VWAPCalculator<3> perTick;
+    std::vector<double> vwaps(4);
+    std::vector<double> examplePrices{100.0, 102.0, 98.0, 104.0};
+    std::vector<int> exampleVolumes{10, 20, 30, 40};
+    perTick.addTicks(examplePrices, exampleVolumes, vwaps);
+    std::cout << "VWAP after each tick:";
+    for (double v : vwaps) {
+        std::cout << " " << v;
+    }
+    std::cout << " (Expected: 100.0 101.3333 99.6667 101.5556)" << std::endl;
+
+    try {
+        batch.addTicks(std::vector<double>{101.0, 102.0}, std::vector<int>{5, 0});
+    } catch (const std::invalid_argument &e) {
+        std::cout << "Rejected batch: " << e.what() << ", window unchanged: " << batch.getVWAP()
+                  << std::endl;
+    }
+
+    // Shared TickRecords, as handed out by TickFileReader
+    std::vector<TickRecord> records;
+    for (int i = 1; i <= 150; ++i) {
+        records.push_back(TickRecord::make("XYZ", 100.0 + (i % 20) - 10, 10 + (i % 5), i));
+    }
+    VWAPCalculator fromRecords;
+    fromRecords.addTicks(records);
+    std::cout << "Batch of 150 records - VWAP: " << fromRecords.getVWAP()
+              << ", Window size: " << fromRecords.getTickCount() << std::endl;
+
+    // Several time horizons answered from one bucket ring
+    std::cout << "\n=== Testing time-windowed VWAP (1s/1m/5m/30m) ===" << std::endl;
+    TimeWindowVWAP timed(1000, {1000, 60 * 1000, 5 * 60 * 1000, 30 * 60 * 1000});
+    long long start = 1700000000000LL;
+    for (long long t = 0; t <= 40LL * 60 * 1000; t += 250) {
+        // Price drifts up one cent per second
+        timed.addTick(start + t, 100.0 + 0.01 * static_cast<double>(t / 1000), 10);
+        if (t > 0 && t % (10LL * 60 * 1000) == 0) {
+            std::cout << "At " << t / 60000 << "m:";
+            for (size_t h = 0; h < timed.getHorizonCount(); ++h) {
+                std::cout << " " << timed.getHorizonMs(h) / 1000 << "s=" << timed.getVWAP(h);
+            }
+            std::cout << std::endl;
+        }
+    }
+    timed.advanceTo(start + 41LL * 60 * 1000);
+    std::cout << "After a quiet minute, 1m volume: " << timed.getTotalVolume(1)
+              << ", 30m volume: " << timed.getTotalVolume(3) << std::endl;
+
     return 0;
 }
\ No newline at end of file